@@ -382,6 +382,23 @@ void UAITask_SVONavMoveTo::RequestPathSynchronous()
 	}
 }
 
+void UAITask_SVONavMoveTo::RequestPathIncremental()
+{
+	SVOResult.Code = ESVONavPathfindingRequestResult::Failed;
+
+#if WITH_EDITOR
+	UE_VLOG(this, VLogSVONav, Log, TEXT("SVONavMoveTo: Requesting incremental replan!"));
+#endif
+
+	ESVONavPathFindingCallResult CallResult;
+	if (SVONavComponent->FindPathIncremental(SVONavComponent->GetPawnPosition(),
+	                                         MoveRequest.GetGoalActor()->GetActorLocation(), &SVONavPath,
+	                                         CallResult))
+	{
+		SVOResult.Code = ESVONavPathfindingRequestResult::Success;
+	}
+}
+
 void UAITask_SVONavMoveTo::RequestPathAsync()
 {
 	SVOResult.Code = ESVONavPathfindingRequestResult::Failed;
@@ -573,7 +590,15 @@ void UAITask_SVONavMoveTo::PerformMove()
 	// If we're ready to path, then request the path
 	if (SVOResult.Code == ESVONavPathfindingRequestResult::ReadyToPath)
 	{
-		UseAsyncPathfinding ? RequestPathAsync() : RequestPathSynchronous();
+		if (bUseContinuousTracking && MoveRequest.IsMoveToActorRequest() &&
+			SVONavComponent->bUseIncrementalReplanning)
+		{
+			RequestPathIncremental();
+		}
+		else
+		{
+			UseAsyncPathfinding ? RequestPathAsync() : RequestPathSynchronous();
+		}
 
 		switch (SVOResult.Code)
 		{
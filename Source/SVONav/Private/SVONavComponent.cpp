@@ -38,7 +38,25 @@ void USVONavComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// ...
+	if (!PathQuery) return;
+
+	// An anytime query signals with its first path and keeps improving that path on later ticks
+	if (PathQuery->Step(SliceExpansionBudget, SliceTimeBudget) != ESVONavPathQueryStatus::InProgress &&
+		PathQueryCompleteFlag)
+	{
+		*PathQueryCompleteFlag = true;
+		PathQueryCompleteFlag = nullptr;
+	}
+
+	if (PathQuery->IsComplete())
+	{
+#if WITH_EDITOR
+		if (bDebugLogPathfinding) UE_LOG(LogTemp, Display, TEXT("%s: Time sliced query finished after %i expansions"),
+		                                 *GetOwner()->GetName(), PathQuery->GetExpansions());
+#endif
+
+		PathQuery.Reset();
+	}
 }
 
 void USVONavComponent::FindPathAsync(const FVector& StartLocation, const FVector& TargetLocation,
@@ -164,16 +182,25 @@ void USVONavComponent::FindPathAsync(const FVector& StartLocation, const FVector
 #endif
 	}
 
-	FSVONavPathFindingConfig Config;
-	Config.Algorithm = Algorithm;
-	Config.Heuristic = Heuristic;
-	Config.EstimateWeight = HeuristicWeight;
-	Config.NodeSizePreference = NodeSizePreference;
-	Config.PathPruning = PathPruning;
-	Config.PathSmoothing = PathSmoothing;
-	Config.UseUnitCost = bUseUnitCost;
-	Config.UnitCost = UnitCost;
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
 
+	if (bTimeSlicedPathfinding && FSVONavPathQuery::SupportsAlgorithm(Config.Algorithm))
+	{
+		// Stepped from TickComponent. A query still pending is completed unbuilt, so its caller sees a failed search
+		if (PathQueryCompleteFlag && PathQueryCompleteFlag != &CompleteFlag) *PathQueryCompleteFlag = true;
+		PathQuery = MakeUnique<FSVONavPathQuery>(GetWorld(), this, *Volume, *HieVolume, Config, StartLink, TargetLink,
+		                                         LegalStart, LegalTarget, NavPath);
+		PathQueryCompleteFlag = &CompleteFlag;
+		Result = ESVONavPathFindingCallResult::Success;
+		return;
+	}
+
+#if WITH_EDITOR
+	if (bTimeSlicedPathfinding && bDebugLogPathfinding) UE_LOG(LogTemp, Warning,
+	                                                           TEXT("%s: %s cannot be time sliced, running a task"),
+	                                                           *GetOwner()->GetName(),
+	                                                           *UEnum::GetValueAsString(Config.Algorithm));
+#endif
 
 	(new FAutoDeleteAsyncTask<FSVONavFindPathTask>(
 		*Volume,
@@ -197,6 +224,52 @@ void USVONavComponent::FindPathAsync(const FVector& StartLocation, const FVector
 #endif
 }
 
+FSVONavPathBatchRef USVONavComponent::FindPathBatchAsync(const TArray<FSVONavPathRequest>& Requests)
+{
+	FSVONavPathBatchRef Batch = MakeShared<FSVONavPathBatch, ESPMode::ThreadSafe>();
+	Batch->Requests = Requests;
+	Batch->Results.SetNum(Requests.Num());
+	Batch->StartLinks.SetNum(Requests.Num());
+	Batch->TargetLinks.SetNum(Requests.Num());
+
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree())
+	{
+		for (FSVONavPathBatchResult& Result : Batch->Results) Result.Result = ESVONavPathFindingCallResult::NoOctree;
+		Batch->bComplete = true;
+		return Batch;
+	}
+
+	// Links are resolved here, nearby accessible links may need world queries
+	for (int32 I = 0; I < Requests.Num(); I++)
+	{
+		FSVONavPathRequest& Request = Batch->Requests[I];
+		FSVONavPathBatchResult& Result = Batch->Results[I];
+		Result.Path = MakeShareable<FSVONavPath>(new FSVONavPath());
+		if (!Volume->GetLink(Request.StartLocation, Batch->StartLinks[I]) &&
+			!Volume->FindAccessibleLink(Request.StartLocation, Batch->StartLinks[I]))
+		{
+			Result.Result = ESVONavPathFindingCallResult::NoStart;
+			Batch->StartLinks[I].Invalidate();
+		}
+		else if (!Volume->GetLink(Request.TargetLocation, Batch->TargetLinks[I]) &&
+			!Volume->FindAccessibleLink(Request.TargetLocation, Batch->TargetLinks[I]))
+		{
+			Result.Result = ESVONavPathFindingCallResult::NoTarget;
+			Batch->TargetLinks[I].Invalidate();
+		}
+	}
+
+#if WITH_EDITOR
+	if (bDebugLogPathfinding) UE_LOG(LogTemp, Display, TEXT("%s: Path batch of %i requests started"),
+	                                 *GetOwner()->GetName(), Requests.Num());
+#endif
+
+	(new FAutoDeleteAsyncTask<FSVONavFindPathBatchTask>(*Volume, *HieVolume, GetWorld(), this, Batch))->
+		StartBackgroundTask();
+	return Batch;
+}
+
 bool USVONavComponent::FindPathImmediate(const FVector& StartLocation, const FVector& TargetLocation,
                                          const bool bCheckLineOfSight, FSVONavPathSharedPtr* NavPath,
                                          ESVONavPathFindingCallResult& Result)
@@ -343,17 +416,9 @@ bool USVONavComponent::FindPathImmediate(const FVector& StartLocation, const FVe
 
 	FSVONavPath* Path = NavPath->Get();
 
-	Path->Empty();
+	Path->Reset();
 
-	FSVONavPathFindingConfig Config;
-	Config.Algorithm = Algorithm;
-	Config.Heuristic = Heuristic;
-	Config.EstimateWeight = HeuristicWeight;
-	Config.NodeSizePreference = NodeSizePreference;
-	Config.PathPruning = PathPruning;
-	Config.PathSmoothing = PathSmoothing;
-	Config.UseUnitCost = bUseUnitCost;
-	Config.UnitCost = UnitCost;
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
 
 	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
 
@@ -370,6 +435,230 @@ bool USVONavComponent::FindPathImmediate(const FVector& StartLocation, const FVe
 	return true;
 }
 
+bool USVONavComponent::FindPathIncremental(const FVector& StartLocation, const FVector& TargetLocation,
+                                           FSVONavPathSharedPtr* NavPath, ESVONavPathFindingCallResult& Result)
+{
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree())
+	{
+		Result = ESVONavPathFindingCallResult::NoOctree;
+		return false;
+	}
+
+	// Same nearby fallback as the other queries when an end point sits in blocked space
+	FSVONavLink StartLink;
+	FSVONavLink TargetLink;
+	FVector LegalStart = StartLocation;
+	FVector LegalTarget = TargetLocation;
+	if (!Volume->GetLink(LegalStart, StartLink) && !Volume->FindAccessibleLink(LegalStart, StartLink))
+	{
+		Result = ESVONavPathFindingCallResult::NoStart;
+		return false;
+	}
+	if (!Volume->GetLink(LegalTarget, TargetLink) && !Volume->FindAccessibleLink(LegalTarget, TargetLink))
+	{
+		Result = ESVONavPathFindingCallResult::NoTarget;
+		return false;
+	}
+
+	if (!IncrementalPlanner || !IncrementalPlanner->IsForVolume(Volume))
+	{
+		IncrementalPlanner = MakeUnique<FSVONavIncrementalPlanner>(*Volume);
+	}
+
+	NavPath->Get()->Reset();
+
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
+	Result = ESVONavPathFindingCallResult::Success;
+	if (!IncrementalPlanner->FindPath(StartLink, TargetLink, LegalStart, LegalTarget, Config, NavPath))
+	{
+#if WITH_EDITOR
+		if (bDebugLogPathfinding) UE_LOG(LogTemp, Warning, TEXT("%s: Incremental planner found no path"),
+		                                 *GetOwner()->GetName());
+#endif
+
+		return false;
+	}
+	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
+	PathFinder.ApplyPathPruning(NavPath, Config);
+	SVONavPathFinder::ApplyPathSmoothing(NavPath, Config);
+
+#if WITH_EDITOR
+	if (bDebugLogPathfinding) UE_LOG(LogTemp, Display, TEXT("%s: Incremental replan expanded %i links"),
+	                                 *GetOwner()->GetName(), IncrementalPlanner->GetLastExpansions());
+#endif
+
+	return true;
+}
+
+bool USVONavComponent::FindPathToNearestImmediate(const FVector& StartLocation, const TArray<FVector>& TargetLocations,
+                                                  FSVONavPathSharedPtr* NavPath, int32& OutTargetIndex,
+                                                  ESVONavPathFindingCallResult& Result)
+{
+	OutTargetIndex = INDEX_NONE;
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree())
+	{
+		Result = ESVONavPathFindingCallResult::NoOctree;
+		return false;
+	}
+
+	FSVONavLink StartLink;
+	if (!Volume->GetLink(StartLocation, StartLink))
+	{
+		Result = ESVONavPathFindingCallResult::NoStart;
+		return false;
+	}
+
+	// Targets outside the octree stay in as invalid links, so indices keep matching TargetLocations
+	TArray<FSVONavLink> TargetLinks;
+	TargetLinks.SetNum(TargetLocations.Num());
+	bool bAnyTarget = false;
+	for (int32 I = 0; I < TargetLocations.Num(); I++)
+	{
+		if (Volume->GetLink(TargetLocations[I], TargetLinks[I])) bAnyTarget = true;
+		else TargetLinks[I].Invalidate();
+	}
+	if (!bAnyTarget)
+	{
+		Result = ESVONavPathFindingCallResult::NoTarget;
+		return false;
+	}
+
+	NavPath->Get()->Reset();
+
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
+	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
+	Result = ESVONavPathFindingCallResult::Success;
+	if (!PathFinder.FindPathToNearest(StartLink, TargetLinks, StartLocation, TargetLocations, NavPath, OutTargetIndex))
+	{
+#if WITH_EDITOR
+		if (bDebugLogPathfinding) UE_LOG(LogTemp, Warning, TEXT("%s: None of the %i targets is reachable"),
+		                                 *GetOwner()->GetName(), TargetLocations.Num());
+#endif
+
+		return false;
+	}
+
+#if WITH_EDITOR
+	if (bDebugLogPathfinding) UE_LOG(LogTemp, Display, TEXT("%s: Nearest target is %i of %i"),
+	                                 *GetOwner()->GetName(), OutTargetIndex, TargetLocations.Num());
+	if (bDebugDrawEnabled) PathFinder.DrawDebug(GetWorld(), *Volume, NavPath);
+#endif
+
+	return true;
+}
+
+bool USVONavComponent::FindPathCostImmediate(const FVector& StartLocation, const FVector& TargetLocation,
+                                             float& OutCost, ESVONavPathFindingCallResult& Result)
+{
+	OutCost = -1.f;
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree())
+	{
+		Result = ESVONavPathFindingCallResult::NoOctree;
+		return false;
+	}
+
+	FSVONavLink StartLink;
+	if (!Volume->GetLink(StartLocation, StartLink))
+	{
+		Result = ESVONavPathFindingCallResult::NoStart;
+		return false;
+	}
+
+	FSVONavLink TargetLink;
+	if (!Volume->GetLink(TargetLocation, TargetLink))
+	{
+		Result = ESVONavPathFindingCallResult::NoTarget;
+		return false;
+	}
+
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
+	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
+	Result = ESVONavPathFindingCallResult::Success;
+	OutCost = PathFinder.FindPathCost(StartLink, TargetLink);
+	return OutCost >= 0.f;
+}
+
+bool USVONavComponent::FindCostMatrixImmediate(const TArray<FVector>& StartLocations,
+                                               const TArray<FVector>& TargetLocations, TArray<float>& OutCosts,
+                                               ESVONavPathFindingCallResult& Result)
+{
+	OutCosts.Init(-1.f, StartLocations.Num() * TargetLocations.Num());
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree())
+	{
+		Result = ESVONavPathFindingCallResult::NoOctree;
+		return false;
+	}
+
+	// Locations outside the octree stay in as invalid links, so the matrix keeps its shape
+	const auto GetLinks = [this](const TArray<FVector>& Locations, TArray<FSVONavLink>& OutLinks)
+	{
+		bool bAnyLink = false;
+		OutLinks.SetNum(Locations.Num());
+		for (int32 I = 0; I < Locations.Num(); I++)
+		{
+			if (Volume->GetLink(Locations[I], OutLinks[I])) bAnyLink = true;
+			else OutLinks[I].Invalidate();
+		}
+		return bAnyLink;
+	};
+
+	TArray<FSVONavLink> StartLinks;
+	if (!GetLinks(StartLocations, StartLinks))
+	{
+		Result = ESVONavPathFindingCallResult::NoStart;
+		return false;
+	}
+
+	TArray<FSVONavLink> TargetLinks;
+	if (!GetLinks(TargetLocations, TargetLinks))
+	{
+		Result = ESVONavPathFindingCallResult::NoTarget;
+		return false;
+	}
+
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
+	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
+	Result = ESVONavPathFindingCallResult::Success;
+	PathFinder.FindCostMatrix(StartLinks, TargetLinks, OutCosts);
+
+#if WITH_EDITOR
+	if (bDebugLogPathfinding) UE_LOG(LogTemp, Display, TEXT("%s: Cost matrix of %i starts by %i targets"),
+	                                 *GetOwner()->GetName(), StartLocations.Num(), TargetLocations.Num());
+#endif
+
+	return true;
+}
+
+bool USVONavComponent::GetFlowFieldDirection(AActor* Goal, FVector& OutDirection, float& OutDistance)
+{
+	if (!Goal) return false;
+	if (!VolumeContainsOctree()) FindVolume();
+	if (!VolumeContainsOctree()) return false;
+
+	if (!FlowField || !FlowField->IsForVolume(Volume) || FlowFieldGoal != Goal)
+	{
+		FlowField = FSVONavFlowFieldRegistry::Get().FindOrAdd(*Volume, Goal);
+		FlowFieldGoal = Goal;
+	}
+
+	// Every agent on the field moves its goal, only the first one after the goal changes node pays for it
+	const FVector GoalLocation = Goal->GetActorLocation();
+	if (!FlowField->SetGoal(GoalLocation, FlowFieldRadius)) return false;
+
+	const FVector Position = GetPawnPosition();
+	FSVONavLink Link;
+	FSVONavLink NextHop;
+	if (!Volume->GetLink(Position, Link) || !FlowField->Sample(Link, NextHop, OutDistance)) return false;
+
+	const FVector Target = NextHop == Link ? GoalLocation : Volume->GetLinkCentre(NextHop);
+	OutDirection = (Target - Position).GetSafeNormal();
+	return true;
+}
+
 bool USVONavComponent::DoesPathExist(const FVector StartLocation, const FVector TargetLocation)
 {
 	FSVONavLink StartLink;
@@ -380,13 +669,7 @@ bool USVONavComponent::DoesPathExist(const FVector StartLocation, const FVector
 	// Error checking before task start
 	if (!CheckHieVolumeCondition(StartLink, TargetLink, StartLocation, TargetLocation)) return false;
 
-	int32 LayerIndex;
-	int32 NodeIndex;
-	FSVONavLink TopStartLink;
-	FSVONavLink TopTargetLink;
-	TArray<FSVONavLink> StartLinkLevels;
-    TArray<FSVONavLink> TargetLinksLevels;
-	return DoesPathExistInternal(StartLink, TargetLink, LayerIndex, NodeIndex, TopStartLink, TopTargetLink, StartLinkLevels, TargetLinksLevels);
+	return HieVolume->IsReachable(StartLink, TargetLink);
 }
 
 bool USVONavComponent::DoesPathExistInternal(const FSVONavLink& StartLink, const FSVONavLink& TargetLink,
@@ -518,17 +801,9 @@ bool USVONavComponent::FindPathHierarchicalImmediate(const FVector& StartLocatio
 
 	FSVONavPath* Path = NavPath->Get();
 
-	Path->Empty();
+	Path->Reset();
 
-	FSVONavPathFindingConfig Config;
-	Config.Algorithm = Algorithm;
-	Config.Heuristic = Heuristic;
-	Config.EstimateWeight = HeuristicWeight;
-	Config.NodeSizePreference = NodeSizePreference;
-	Config.PathPruning = PathPruning;
-	Config.PathSmoothing = PathSmoothing;
-	Config.UseUnitCost = bUseUnitCost;
-	Config.UnitCost = UnitCost;
+	FSVONavPathFindingConfig Config = GetPathFindingConfig();
 
 	SVONavPathFinder PathFinder(GetWorld(), this, *Volume, *HieVolume, Config);
 
@@ -643,6 +918,24 @@ bool USVONavComponent::CheckHieVolumeCondition(FSVONavLink& StartLink,
 	return true;
 }
 
+FSVONavPathFindingConfig USVONavComponent::GetPathFindingConfig() const
+{
+	FSVONavPathFindingConfig Config;
+	Config.Algorithm = Algorithm;
+	Config.Heuristic = Heuristic;
+	Config.EstimateWeight = HeuristicWeight;
+	Config.NodeSizePreference = NodeSizePreference;
+	Config.PathPruning = PathPruning;
+	Config.PathSmoothing = PathSmoothing;
+	Config.UseUnitCost = bUseUnitCost;
+	Config.UnitCost = UnitCost;
+	Config.AnytimeWeightStep = AnytimeWeightStep;
+	Config.MaxExpansions = MaxExpansions;
+	Config.TimeBudget = TimeBudget;
+	Config.UsePathCache = bUsePathCache;
+	return Config;
+}
+
 FVector USVONavComponent::GetPawnPosition() const
 {
 	FVector Result;
@@ -0,0 +1,11 @@
+﻿#include "SVONavCostModifierVolume.h"
+
+#include "Components/BrushComponent.h"
+
+ASVONavCostModifierVolume::ASVONavCostModifierVolume(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// Only read when baking, it must not block anything
+	GetBrushComponent()->SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+	BrushColor = FColor(255, 128, 0, 255);
+}
@@ -1,6 +1,7 @@
 ﻿#include "SVONavFindPathTask.h"
 
 #include "SVONavPathFinder.h"
+#include "Async/ParallelFor.h"
 
 void FSVONavFindPathTask::DoWork()
 {
@@ -23,3 +24,62 @@ void FSVONavFindPathTask::DoWork()
 	CompleteFlag = true;
 	//});
 }
+
+void FSVONavFindPathBatchTask::DoWork()
+{
+	FSVONavPathBatch& PathBatch = Batch.Get();
+
+	// Request indices per target region and config
+	TArray<TArray<int32>> Groups;
+	TMap<TPair<FSVONavLink, uint32>, int32> GroupIndices;
+
+	for (int32 I = 0; I < PathBatch.Requests.Num(); I++)
+	{
+		if (!PathBatch.StartLinks[I].IsValid() || !PathBatch.TargetLinks[I].IsValid()) continue;
+
+		const uint32 ConfigHash = PathBatch.Requests[I].Config.GetSearchHash();
+		const TPair<FSVONavLink, uint32> Key(GetTargetRegion(PathBatch.TargetLinks[I]), ConfigHash);
+		int32* GroupIndex = GroupIndices.Find(Key);
+		if (!GroupIndex) GroupIndex = &GroupIndices.Add(Key, Groups.AddDefaulted());
+		Groups[*GroupIndex].Add(I);
+	}
+
+	ParallelFor(Groups.Num(), [this, &PathBatch, &Groups](const int32 GroupIndex)
+	{
+		TArray<int32>& Requests = Groups[GroupIndex];
+		// Requests for the same target run back to back, so the heuristic's target centre is looked up once
+		Requests.Sort([&PathBatch](const int32 A, const int32 B)
+		{
+			return GetTypeHash(PathBatch.TargetLinks[A]) < GetTypeHash(PathBatch.TargetLinks[B]);
+		});
+
+		FSVONavPathFindingConfig Config = PathBatch.Requests[Requests[0]].Config;
+		SVONavPathFinder PathFinder(World, NavComp, Volume, HieVolume, Config);
+		for (const int32 I : Requests)
+		{
+			const FSVONavPathRequest& Request = PathBatch.Requests[I];
+			FSVONavPathBatchResult& Result = PathBatch.Results[I];
+			// The group only shares search settings, pruning and smoothing still follow each request
+			Config = Request.Config;
+			Result.bPathFound = PathFinder.FindPath(PathBatch.StartLinks[I], PathBatch.TargetLinks[I],
+			                                        Request.StartLocation, Request.TargetLocation, Request.Config,
+			                                        &Result.Path) != 0;
+		}
+	});
+
+	PathBatch.bComplete = true;
+}
+
+FSVONavLink FSVONavFindPathBatchTask::GetTargetRegion(const FSVONavLink& TargetLink) const
+{
+	const int32 RegionLayer = FMath::Max(0, Volume.GetLayerCount() - 3);
+	FSVONavLink Region = TargetLink;
+	while (Region.GetLayerIndex() < RegionLayer)
+	{
+		const FSVONavLink& Parent = Volume.GetNode(Region).Parent;
+		if (!Parent.IsValid()) break;
+		Region = Parent;
+	}
+	Region.SetSubNodeIndex(0);
+	return Region;
+}
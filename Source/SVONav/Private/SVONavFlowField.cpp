@@ -0,0 +1,168 @@
+﻿#include "SVONavFlowField.h"
+
+#include "SVONavVolume.h"
+
+FSVONavFlowField::FSVONavFlowField(ASVONavVolume& InVolume)
+	: Volume(InVolume),
+	  OpenList(State)
+{
+	Neighbours.Reserve(64);
+}
+
+bool FSVONavFlowField::SetGoal(const FVector& GoalLocation, const float InMaxDistance)
+{
+	FSVONavLink NewGoalLink;
+	if (!Volume.GetLink(GoalLocation, NewGoalLink)) return false;
+
+	// Node ids of an older octree mean nothing in the current one, and new costs invalidate every distance
+	const uint32 Revision = Volume.GetSearchRevision();
+	if (!bBuilt || Revision != SearchRevision || InMaxDistance != MaxDistance)
+	{
+		SearchRevision = Revision;
+		MaxDistance = InMaxDistance;
+		GoalLink = NewGoalLink;
+		Rebuild();
+	}
+	else if (NewGoalLink != GoalLink && !Reroot(NewGoalLink))
+	{
+		GoalLink = NewGoalLink;
+		Rebuild();
+	}
+	return true;
+}
+
+bool FSVONavFlowField::Sample(const FSVONavLink& Link, FSVONavLink& OutNextHop, float& OutDistance) const
+{
+	if (!bBuilt || Volume.GetSearchRevision() != SearchRevision) return false;
+
+	const FSVONavSearchNode* Node = State.Find(Volume.GetNodeId(Link));
+	if (!Node || !Node->bClosed) return false;
+
+	OutNextHop = Node->Parent;
+	OutDistance = Node->GScore;
+	return true;
+}
+
+void FSVONavFlowField::Rebuild()
+{
+	State.Begin(Volume.GetNodeIdCount());
+	OpenList.Reset();
+	Reached.Reset();
+	LastSweepCount = 0;
+
+	const int32 GoalId = Volume.GetNodeId(GoalLink);
+	FSVONavSearchNode& Goal = State.Get(GoalId);
+	Goal.GScore = 0.f;
+	// The goal is its own next hop
+	Goal.Parent = GoalLink;
+	OpenList.Push(GoalLink, GoalId, 0.f);
+	Sweep();
+
+	bBuilt = true;
+}
+
+bool FSVONavFlowField::Reroot(const FSVONavLink& NewGoalLink)
+{
+	const int32 NewGoalId = Volume.GetNodeId(NewGoalLink);
+	const FSVONavSearchNode* Found = State.Find(NewGoalId);
+	if (!Found || !Found->bClosed) return false;
+	const float Offset = Found->GScore;
+
+	// Only links that reached the old goal through the new one keep their paths, bClosed marks them while walking
+	for (const FSVONavLink& Link : Reached) State.Get(Volume.GetNodeId(Link)).bClosed = false;
+	Subtree.Reset();
+	Subtree.Add(NewGoalLink);
+	State.Get(NewGoalId).bClosed = true;
+	for (int32 I = 0; I < Subtree.Num(); I++)
+	{
+		const FSVONavLink Link = Subtree[I];
+		Volume.GetSearchPredecessors(Link, Neighbours);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+			if (!State.Find(NeighbourId)) continue;
+
+			FSVONavSearchNode& Child = State.Get(NeighbourId);
+			if (Child.bClosed || Child.Parent != Link) continue;
+			Child.bClosed = true;
+			Subtree.Add(Neighbour);
+		}
+	}
+
+	for (const FSVONavLink& Link : Reached)
+	{
+		FSVONavSearchNode& Node = State.Get(Volume.GetNodeId(Link));
+		if (Node.bClosed) continue;
+		Node.GScore = FLT_MAX;
+		Node.Parent = FSVONavLink();
+	}
+	for (const FSVONavLink& Link : Subtree) State.Get(Volume.GetNodeId(Link)).GScore -= Offset;
+	State.Get(NewGoalId).Parent = NewGoalLink;
+
+	// The kept subtree is exact, sweep the rest outwards from its boundary
+	GoalLink = NewGoalLink;
+	OpenList.Reset();
+	Exchange(Reached, Subtree);
+	LastSweepCount = 0;
+	for (const FSVONavLink& Link : Reached) Relax(Link, State.Get(Volume.GetNodeId(Link)).GScore);
+	Sweep();
+	return true;
+}
+
+void FSVONavFlowField::Relax(const FSVONavLink& Link, const float Distance)
+{
+	const FVector Centre = Volume.GetLinkCentre(Link);
+	// Agents step from the neighbour into Link, so the sweep walks the volume's reverse adjacency
+	const float CostScale = Volume.GetCostScale(Link);
+	Volume.GetSearchPredecessors(Link, Neighbours);
+	for (const FSVONavLink& Neighbour : Neighbours)
+	{
+		const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+		FSVONavSearchNode& Node = State.Get(NeighbourId);
+		if (Node.bClosed) continue;
+
+		const float NeighbourDistance = Distance + (Volume.GetLinkCentre(Neighbour) - Centre).Size() * CostScale;
+		if (NeighbourDistance >= Node.GScore || (MaxDistance > 0.f && NeighbourDistance > MaxDistance)) continue;
+		Node.GScore = NeighbourDistance;
+		Node.Parent = Link;
+		OpenList.Push(Neighbour, NeighbourId, NeighbourDistance);
+	}
+}
+
+void FSVONavFlowField::Sweep()
+{
+	while (!OpenList.IsEmpty())
+	{
+		const int32 NodeId = OpenList.GetTopId();
+		const FSVONavLink Link = OpenList.Pop();
+		FSVONavSearchNode& Node = State.Get(NodeId);
+		Node.bClosed = true;
+		Reached.Add(Link);
+		LastSweepCount++;
+
+		Relax(Link, Node.GScore);
+	}
+}
+
+FSVONavFlowFieldRegistry& FSVONavFlowFieldRegistry::Get()
+{
+	static FSVONavFlowFieldRegistry Registry;
+	return Registry;
+}
+
+TSharedRef<FSVONavFlowField> FSVONavFlowFieldRegistry::FindOrAdd(ASVONavVolume& Volume, const AActor* Goal)
+{
+	const TPair<FObjectKey, FObjectKey> Key(FObjectKey(&Volume), FObjectKey(Goal));
+	if (const TSharedRef<FSVONavFlowField>* Field = Fields.Find(Key)) return *Field;
+
+	Trim();
+	return Fields.Add(Key, MakeShared<FSVONavFlowField>(Volume));
+}
+
+void FSVONavFlowFieldRegistry::Trim()
+{
+	for (auto It = Fields.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().Key.ResolveObjectPtr() || !It.Key().Value.ResolveObjectPtr()) It.RemoveCurrent();
+	}
+}
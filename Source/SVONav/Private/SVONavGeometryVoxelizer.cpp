@@ -0,0 +1,413 @@
+﻿#include "SVONavGeometryVoxelizer.h"
+
+#include "EngineUtils.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "LandscapeDataAccess.h"
+#include "LandscapeHeightfieldCollisionComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+	// Box corners in morton order, and the two triangles of each box face
+	const int32 BoxIndices[36] = {
+		0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3,
+		0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6,
+		0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5
+	};
+
+	void GetBoxCorners(const FTransform& Transform, const FVector& HalfExtent, TArray<FVector>& OutCorners)
+	{
+		OutCorners.Reset(8);
+		for (int32 I = 0; I < 8; I++)
+		{
+			const FVector Corner((I & 1) ? HalfExtent.X : -HalfExtent.X,
+			                     (I & 2) ? HalfExtent.Y : -HalfExtent.Y,
+			                     (I & 4) ? HalfExtent.Z : -HalfExtent.Z);
+			OutCorners.Add(Transform.TransformPosition(Corner));
+		}
+	}
+}
+
+void FSVONavGeometryVoxelizer::Gather(const UWorld* World, const FBox& Bounds, const ECollisionChannel Channel)
+{
+	Triangles.Reset();
+	Planes.Reset();
+	Solids.Reset();
+	GridBounds = Bounds;
+	if (!World) return;
+
+	TArray<FVector> Vertices;
+	TArray<int32> Indices(BoxIndices, 36);
+	TArray<int32> MeshIndices;
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> Components(*It);
+		for (UPrimitiveComponent* Component : Components)
+		{
+			if (!Component->IsRegistered()) continue;
+			if (!Component->IsQueryCollisionEnabled() || Component->GetCollisionResponseToChannel(Channel) != ECR_Block) continue;
+			if (!Component->Bounds.GetBox().Intersect(Bounds)) continue;
+
+			if (ULandscapeHeightfieldCollisionComponent* Landscape = Cast<ULandscapeHeightfieldCollisionComponent>(Component))
+			{
+				AddHeightfield(Landscape);
+				continue;
+			}
+
+			UBodySetup* BodySetup = Component->GetBodySetup();
+			if (!BodySetup) continue;
+
+			const FTransform ComponentTransform = Component->GetComponentTransform();
+			const float RadiusScale = ComponentTransform.GetMaximumAxisScale();
+			const FKAggregateGeom& Geometry = BodySetup->AggGeom;
+
+			// Complex collision only stands in for the simple shapes when the body asks for it
+			UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+			if (BodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple && MeshComponent &&
+				MeshComponent->GetStaticMesh())
+			{
+				FTriMeshCollisionData MeshData;
+				if (MeshComponent->GetStaticMesh()->GetPhysicsTriMeshData(&MeshData, true))
+				{
+					Vertices.Reset(MeshData.Vertices.Num());
+					for (const FVector& Vertex : MeshData.Vertices) Vertices.Add(ComponentTransform.TransformPosition(Vertex));
+					MeshIndices.Reset(MeshData.Indices.Num() * 3);
+					for (const FTriIndices& Triangle : MeshData.Indices)
+					{
+						MeshIndices.Add(Triangle.v0);
+						MeshIndices.Add(Triangle.v1);
+						MeshIndices.Add(Triangle.v2);
+					}
+					AddTriangles(Vertices, MeshIndices);
+				}
+				continue;
+			}
+
+			for (const FKBoxElem& Box : Geometry.BoxElems)
+			{
+				GetBoxCorners(Box.GetTransform() * ComponentTransform, FVector(Box.X, Box.Y, Box.Z) * 0.5f, Vertices);
+				AddConvex(Vertices, Indices);
+			}
+			for (const FKConvexElem& Convex : Geometry.ConvexElems)
+			{
+				const FTransform Transform = Convex.GetTransform() * ComponentTransform;
+				Vertices.Reset(Convex.VertexData.Num());
+				for (const FVector& Vertex : Convex.VertexData) Vertices.Add(Transform.TransformPosition(Vertex));
+				AddConvex(Vertices, Convex.IndexData);
+			}
+			for (const FKSphereElem& Sphere : Geometry.SphereElems)
+			{
+				const FVector Centre = ComponentTransform.TransformPosition(Sphere.Center);
+				AddRoundSolid(Centre, Centre, Sphere.Radius * RadiusScale);
+			}
+			for (const FKSphylElem& Capsule : Geometry.SphylElems)
+			{
+				const FVector Axis = Capsule.Rotation.RotateVector(FVector(0.f, 0.f, Capsule.Length * 0.5f));
+				AddRoundSolid(ComponentTransform.TransformPosition(Capsule.Center - Axis),
+				              ComponentTransform.TransformPosition(Capsule.Center + Axis),
+				              Capsule.Radius * RadiusScale);
+			}
+		}
+	}
+
+	BuildGrid();
+}
+
+void FSVONavGeometryVoxelizer::AddConvex(const TArray<FVector>& Vertices, const TArray<int32>& Indices)
+{
+	if (Vertices.Num() < 4 || Indices.Num() < 3) return;
+
+	FSolid Solid;
+	Solid.Type = ESolidType::Convex;
+	Solid.Bounds = FBox(Vertices);
+	if (!Solid.Bounds.Intersect(GridBounds)) return;
+
+	// Cooked hulls do not promise a winding, face planes are turned to point away from the vertex average
+	FVector Centroid = FVector::ZeroVector;
+	for (const FVector& Vertex : Vertices) Centroid += Vertex;
+	Centroid /= Vertices.Num();
+	Solid.FirstPlane = Planes.Num();
+	for (int32 I = 0; I + 2 < Indices.Num(); I += 3)
+	{
+		const FVector& A = Vertices[Indices[I]];
+		FVector Normal = (Vertices[Indices[I + 1]] - A) ^ (Vertices[Indices[I + 2]] - A);
+		if (!Normal.Normalize()) continue;
+		if ((Centroid - A | Normal) > 0.f) Normal = -Normal;
+		Planes.Emplace(A, Normal);
+	}
+	Solid.NumPlanes = Planes.Num() - Solid.FirstPlane;
+	Solids.Add(Solid);
+
+	AddTriangles(Vertices, Indices);
+}
+
+void FSVONavGeometryVoxelizer::AddRoundSolid(const FVector& Start, const FVector& End, const float Radius)
+{
+	FSolid Solid;
+	Solid.Type = Start == End ? ESolidType::Sphere : ESolidType::Capsule;
+	Solid.Bounds = FBox(Start.ComponentMin(End) - Radius, Start.ComponentMax(End) + Radius);
+	if (!Solid.Bounds.Intersect(GridBounds)) return;
+
+	Solid.Start = Start;
+	Solid.End = End;
+	Solid.Radius = Radius;
+	Solids.Add(Solid);
+}
+
+void FSVONavGeometryVoxelizer::AddTriangles(const TArray<FVector>& Vertices, const TArray<int32>& Indices)
+{
+	for (int32 I = 0; I + 2 < Indices.Num(); I += 3)
+	{
+		const FVector& A = Vertices[Indices[I]];
+		const FVector& B = Vertices[Indices[I + 1]];
+		const FVector& C = Vertices[Indices[I + 2]];
+		const FBox Bounds(A.ComponentMin(B).ComponentMin(C), A.ComponentMax(B).ComponentMax(C));
+		if (!Bounds.Intersect(GridBounds)) continue;
+
+		Triangles.Add(A);
+		Triangles.Add(B);
+		Triangles.Add(C);
+	}
+}
+
+void FSVONavGeometryVoxelizer::AddHeightfield(ULandscapeHeightfieldCollisionComponent* Component)
+{
+	const int32 Size = Component->CollisionSizeQuads + 1;
+	if (Size < 2) return;
+
+	const FTransform ComponentTransform = Component->GetComponentTransform();
+	const float Scale = Component->CollisionScale;
+	TArray<FVector> Vertices;
+	TBitArray<> Valid(true, Size * Size);
+
+	// Heights come from the data the heightfield was cooked from. Cooked builds only keep the physics heightfield,
+	// there each vertex is found with a trace down the component and vertices over holes drop their triangles
+#if WITH_EDITORONLY_DATA
+	if (Component->CollisionHeightData.GetElementCount() == Size * Size)
+	{
+		const uint16* Heights = static_cast<const uint16*>(Component->CollisionHeightData.LockReadOnly());
+		Vertices.Reserve(Size * Size);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const float Height = LandscapeDataAccess::GetLocalHeight(Heights[Y * Size + X]);
+				Vertices.Add(ComponentTransform.TransformPosition(FVector(X * Scale, Y * Scale, Height)));
+			}
+		}
+		Component->CollisionHeightData.Unlock();
+	}
+#endif
+	if (Vertices.Num() == 0)
+	{
+		const FBox ComponentBounds = Component->Bounds.GetBox();
+		const FCollisionQueryParams Params(TEXT("SVONavHeightfield"), true);
+		Vertices.Reserve(Size * Size);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const FVector Location = ComponentTransform.TransformPosition(FVector(X * Scale, Y * Scale, 0.f));
+				FHitResult Hit;
+				const bool bHit = Component->LineTraceComponent(Hit, FVector(Location.X, Location.Y, ComponentBounds.Max.Z + 1.f),
+				                                                FVector(Location.X, Location.Y, ComponentBounds.Min.Z - 1.f), Params);
+				Valid[Vertices.Num()] = bHit;
+				Vertices.Add(bHit ? Hit.ImpactPoint : Location);
+			}
+		}
+	}
+
+	// Each quad splits along the same diagonal as the physics heightfield
+	TArray<int32> Indices;
+	Indices.Reserve((Size - 1) * (Size - 1) * 6);
+	for (int32 Y = 0; Y + 1 < Size; Y++)
+	{
+		for (int32 X = 0; X + 1 < Size; X++)
+		{
+			const int32 I00 = Y * Size + X;
+			const int32 I10 = I00 + 1;
+			const int32 I01 = I00 + Size;
+			const int32 I11 = I01 + 1;
+			if (!Valid[I00] || !Valid[I10] || !Valid[I01] || !Valid[I11]) continue;
+
+			Indices.Append({I00, I11, I10, I00, I01, I11});
+		}
+	}
+	AddTriangles(Vertices, Indices);
+}
+
+void FSVONavGeometryVoxelizer::BuildGrid()
+{
+	CellSize = GridBounds.GetSize() / GridResolution;
+	TriangleCells.Reset();
+	SolidCells.Reset();
+	TriangleCells.SetNum(GridResolution * GridResolution * GridResolution);
+	SolidCells.SetNum(GridResolution * GridResolution * GridResolution);
+
+	const auto Insert = [this](TArray<TArray<int32>>& Cells, const FBox& Bounds, const int32 Index)
+	{
+		FIntVector Min, Max;
+		if (!GetCellRange(Bounds, Min, Max)) return;
+		for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+			{
+				for (int32 X = Min.X; X <= Max.X; X++) Cells[GetCellIndex(X, Y, Z)].Add(Index);
+			}
+		}
+	};
+
+	for (int32 I = 0; I < GetTriangleCount(); I++)
+	{
+		const FVector& A = Triangles[I * 3];
+		const FVector& B = Triangles[I * 3 + 1];
+		const FVector& C = Triangles[I * 3 + 2];
+		Insert(TriangleCells, FBox(A.ComponentMin(B).ComponentMin(C), A.ComponentMax(B).ComponentMax(C)), I);
+	}
+	for (int32 I = 0; I < Solids.Num(); I++) Insert(SolidCells, Solids[I].Bounds, I);
+}
+
+bool FSVONavGeometryVoxelizer::GetCellRange(const FBox& Box, FIntVector& OutMin, FIntVector& OutMax) const
+{
+	if (!Box.Intersect(GridBounds)) return false;
+
+	const FVector Min = (Box.Min - GridBounds.Min) / CellSize;
+	const FVector Max = (Box.Max - GridBounds.Min) / CellSize;
+	OutMin = FIntVector(FMath::Clamp(FMath::FloorToInt(Min.X), 0, GridResolution - 1),
+	                    FMath::Clamp(FMath::FloorToInt(Min.Y), 0, GridResolution - 1),
+	                    FMath::Clamp(FMath::FloorToInt(Min.Z), 0, GridResolution - 1));
+	OutMax = FIntVector(FMath::Clamp(FMath::FloorToInt(Max.X), 0, GridResolution - 1),
+	                    FMath::Clamp(FMath::FloorToInt(Max.Y), 0, GridResolution - 1),
+	                    FMath::Clamp(FMath::FloorToInt(Max.Z), 0, GridResolution - 1));
+	return true;
+}
+
+bool FSVONavGeometryVoxelizer::IsBlocked(const FVector& Centre, const FVector& Extent) const
+{
+	FIntVector Min, Max;
+	if (!GetCellRange(FBox(Centre - Extent, Centre + Extent), Min, Max)) return false;
+
+	const VectorRegister CentreRegister = VectorLoadFloat3_W0(&Centre);
+	const VectorRegister ExtentRegister = VectorLoadFloat3_W0(&Extent);
+	for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			for (int32 X = Min.X; X <= Max.X; X++)
+			{
+				const int32 Cell = GetCellIndex(X, Y, Z);
+				for (const int32 Triangle : TriangleCells[Cell])
+				{
+					if (TriangleBoxOverlap(CentreRegister, ExtentRegister, &Triangles[Triangle * 3])) return true;
+				}
+				// Solids catch boxes that lie entirely inside them and so cross none of their faces
+				for (const int32 Solid : SolidCells[Cell])
+				{
+					if (SolidBoxOverlap(Solids[Solid], Centre, Extent)) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+bool FSVONavGeometryVoxelizer::IsContained(const FVector& Centre, const FVector& Extent) const
+{
+	// Any solid containing the box is listed in the cell of its centre
+	FIntVector Cell;
+	if (!GetCellRange(FBox(Centre, Centre), Cell, Cell)) return false;
+
+	for (const int32 SolidIndex : SolidCells[GetCellIndex(Cell.X, Cell.Y, Cell.Z)])
+	{
+		// Every solid is convex, holding all eight corners means holding the box
+		const FSolid& Solid = Solids[SolidIndex];
+		bool bContained = true;
+		for (int32 I = 0; I < 8 && bContained; I++)
+		{
+			const FVector Corner(I & 1 ? Extent.X : -Extent.X, I & 2 ? Extent.Y : -Extent.Y, I & 4 ? Extent.Z : -Extent.Z);
+			bContained = SolidContainsPoint(Solid, Centre + Corner);
+		}
+		if (bContained) return true;
+	}
+	return false;
+}
+
+bool FSVONavGeometryVoxelizer::TriangleBoxOverlap(const VectorRegister& Centre, const VectorRegister& Extent,
+                                                  const FVector* Vertices)
+{
+	// Separating axis test: the box axes, the triangle normal and the nine box axis and edge cross products. The
+	// spare W lane is zero in every register and never separates anything
+	const VectorRegister V0 = VectorSubtract(VectorLoadFloat3_W0(&Vertices[0]), Centre);
+	const VectorRegister V1 = VectorSubtract(VectorLoadFloat3_W0(&Vertices[1]), Centre);
+	const VectorRegister V2 = VectorSubtract(VectorLoadFloat3_W0(&Vertices[2]), Centre);
+	if (VectorAnyGreaterThan(VectorMin(V0, VectorMin(V1, V2)), Extent) ||
+		VectorAnyGreaterThan(VectorNegate(Extent), VectorMax(V0, VectorMax(V1, V2))))
+	{
+		return false;
+	}
+
+	const VectorRegister Edges[3] = {VectorSubtract(V1, V0), VectorSubtract(V2, V1), VectorSubtract(V0, V2)};
+	const VectorRegister Normal = VectorCross(Edges[0], Edges[1]);
+	if (VectorAnyGreaterThan(VectorAbs(VectorDot3(Normal, V0)), VectorDot3(Extent, VectorAbs(Normal)))) return false;
+
+	// Box axis I cross an edge projects a vertex to component I of the edge cross the vertex, so one edge covers its
+	// three axes at once. The box radius on axis I pairs the other two extents with the other two edge components
+	const VectorRegister ExtentA = VectorSwizzle(Extent, 1, 0, 0, 3);
+	const VectorRegister ExtentB = VectorSwizzle(Extent, 2, 2, 1, 3);
+	for (const VectorRegister& Edge : Edges)
+	{
+		const VectorRegister AbsEdge = VectorAbs(Edge);
+		const VectorRegister Radius = VectorMultiplyAdd(ExtentA, VectorSwizzle(AbsEdge, 2, 2, 1, 3),
+		                                                VectorMultiply(ExtentB, VectorSwizzle(AbsEdge, 1, 0, 0, 3)));
+		const VectorRegister P0 = VectorCross(Edge, V0);
+		const VectorRegister P1 = VectorCross(Edge, V1);
+		const VectorRegister P2 = VectorCross(Edge, V2);
+		if (VectorAnyGreaterThan(VectorMin(P0, VectorMin(P1, P2)), Radius) ||
+			VectorAnyGreaterThan(VectorNegate(Radius), VectorMax(P0, VectorMax(P1, P2))))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FSVONavGeometryVoxelizer::SolidBoxOverlap(const FSolid& Solid, const FVector& Centre, const FVector& Extent) const
+{
+	if (!Solid.Bounds.Intersect(FBox(Centre - Extent, Centre + Extent))) return false;
+
+	switch (Solid.Type)
+	{
+	case ESolidType::Convex:
+		return SolidContainsPoint(Solid, Centre);
+	case ESolidType::Sphere:
+		return FMath::SphereAABBIntersection(Solid.Start, Solid.Radius * Solid.Radius, FBox(Centre - Extent, Centre + Extent));
+	case ESolidType::Capsule:
+		{
+			// Segment against the box grown by the radius, slightly conservative around the box edges
+			const FVector Grown = Extent + Solid.Radius;
+			FVector Hit, Normal;
+			float Time;
+			const FBox Box(Centre - Grown, Centre + Grown);
+			return Box.IsInside(Solid.Start) || FMath::LineExtentBoxIntersection(Box, Solid.Start, Solid.End,
+				FVector::ZeroVector, Hit, Normal, Time);
+		}
+	}
+	return false;
+}
+
+bool FSVONavGeometryVoxelizer::SolidContainsPoint(const FSolid& Solid, const FVector& Point) const
+{
+	if (Solid.Type != ESolidType::Convex)
+	{
+		return FMath::PointDistToSegmentSquared(Point, Solid.Start, Solid.End) <= Solid.Radius * Solid.Radius;
+	}
+
+	for (int32 I = Solid.FirstPlane; I < Solid.FirstPlane + Solid.NumPlanes; I++)
+	{
+		if (Planes[I].PlaneDot(Point) > 0.f) return false;
+	}
+	return true;
+}
@@ -0,0 +1,317 @@
+﻿#include "SVONavIncrementalPlanner.h"
+
+#include "Algo/Reverse.h"
+#include "SVONavVolume.h"
+
+FSVONavIncrementalPlanner::FSVONavIncrementalPlanner(ASVONavVolume& InVolume)
+	: Volume(InVolume),
+	  OpenList(State)
+{
+	Neighbours.Reserve(64);
+	RhsNeighbours.Reserve(64);
+}
+
+bool FSVONavIncrementalPlanner::FindPath(const FSVONavLink& InStartLink,
+                                         const FSVONavLink& InGoalLink,
+                                         const FVector& StartLocation,
+                                         const FVector& GoalLocation,
+                                         const FSVONavPathFindingConfig& InConfig,
+                                         FSVONavPathSharedPtr* Path)
+{
+	LastExpansions = 0;
+
+	// A rebuilt octree renumbers its nodes, nothing of the old tree can be mapped onto it
+	const uint32 Revision = Volume.GetOctreeRevision();
+	// The volume only keeps the links of its last cost update, the tree is repaired for one update at most
+	const uint32 NewCostRevision = Volume.GetCostRevision();
+	const bool bCostUpdatesMissed = NewCostRevision - CostRevision > 1;
+	if (!bInitialised || Revision != OctreeRevision || bCostUpdatesMissed || ConfigChanged(InConfig))
+	{
+		Config = InConfig;
+		OctreeRevision = Revision;
+		CostRevision = NewCostRevision;
+		GoalLink = InGoalLink;
+		Initialise(InStartLink);
+	}
+	else
+	{
+		if (NewCostRevision != CostRevision)
+		{
+			CostRevision = NewCostRevision;
+			NotifyLinksChanged(Volume.GetCostChangedLinks());
+		}
+
+		// Keys are the only thing that depend on the goal
+		if (InGoalLink != GoalLink)
+		{
+			GoalLink = InGoalLink;
+			OpenList.Rebuild([this](const FSVONavLink& Link, const int32 NodeId)
+			{
+				return CalculateKey(State.Get(NodeId), Link);
+			});
+		}
+		if (InStartLink != StartLink && !MoveStart(InStartLink)) Initialise(InStartLink);
+	}
+
+	if (!ComputeShortestPath()) return false;
+
+	BuildPath(StartLocation, GoalLocation, Path);
+	return true;
+}
+
+void FSVONavIncrementalPlanner::NotifyLinksChanged(const TArray<FSVONavLink>& Links)
+{
+	if (!bInitialised) return;
+
+	for (const FSVONavLink& Link : Links)
+	{
+		// Links the tree never reached cannot have fed any other link's cost
+		const int32 NodeId = Volume.GetNodeId(Link);
+		if (!State.Find(NodeId)) continue;
+
+		UpdateRhs(Link, NodeId);
+		UpdateVertex(Link, NodeId);
+
+		Volume.GetSearchNeighbours(Link, Neighbours);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+			if (!State.Find(NeighbourId)) continue;
+			UpdateRhs(Neighbour, NeighbourId);
+			UpdateVertex(Neighbour, NeighbourId);
+		}
+	}
+}
+
+void FSVONavIncrementalPlanner::Initialise(const FSVONavLink& InStartLink)
+{
+	State.BeginSparse();
+	OpenList.Reset();
+	TouchedLinks.Reset();
+	TargetCache = FSVONavTargetCentreCache();
+
+	StartLink = InStartLink;
+	const int32 StartId = Volume.GetNodeId(StartLink);
+	FSVONavSearchNode& Start = Touch(StartLink, StartId);
+	Start.Rhs = 0.f;
+	// The root is its own parent
+	Start.Parent = StartLink;
+	UpdateVertex(StartLink, StartId);
+
+	bInitialised = true;
+}
+
+bool FSVONavIncrementalPlanner::MoveStart(const FSVONavLink& NewStartLink)
+{
+	const int32 NewStartId = Volume.GetNodeId(NewStartLink);
+	const FSVONavSearchNode* Found = State.Find(NewStartId);
+	if (!Found || Found->GScore == FLT_MAX) return false;
+
+	// The subtree hanging off the new start keeps its costs, they are all offset by the same constant.
+	// bClosed is unused by this search, so it marks subtree membership for the duration of the move
+	FSVONavSearchNode& NewStart = State.Get(NewStartId);
+	NewStart.bClosed = true;
+	SubtreeLinks.Reset();
+	SubtreeLinks.Add(NewStartLink);
+	for (int32 I = 0; I < SubtreeLinks.Num(); I++)
+	{
+		const FSVONavLink Link = SubtreeLinks[I];
+		Volume.GetSearchNeighbours(Link, Neighbours);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+			if (!State.Find(NeighbourId)) continue;
+
+			FSVONavSearchNode& Child = State.Get(NeighbourId);
+			if (Child.bClosed || Child.Parent != Link) continue;
+			Child.bClosed = true;
+			SubtreeLinks.Add(Neighbour);
+		}
+	}
+
+	StartLink = NewStartLink;
+	NewStart.Rhs = NewStart.GScore;
+	NewStart.Parent = NewStartLink;
+	UpdateVertex(NewStartLink, NewStartId);
+
+	// Everything else only reached the start through the old root, clear it then let it re-attach to the subtree
+	for (const FSVONavLink& Link : TouchedLinks)
+	{
+		const int32 NodeId = Volume.GetNodeId(Link);
+		FSVONavSearchNode& Node = State.Get(NodeId);
+		if (Node.bClosed) continue;
+		Node.GScore = FLT_MAX;
+		Node.Rhs = FLT_MAX;
+		Node.Parent = FSVONavLink();
+		OpenList.Remove(NodeId);
+	}
+	// Only the subtree and the links bordering it stay, the rest would be rebuilt from scratch anyway
+	int32 NumKept = 0;
+	for (int32 I = 0; I < TouchedLinks.Num(); I++)
+	{
+		const FSVONavLink Link = TouchedLinks[I];
+		const int32 NodeId = Volume.GetNodeId(Link);
+		if (!State.Get(NodeId).bClosed)
+		{
+			UpdateRhs(Link, NodeId);
+			UpdateVertex(Link, NodeId);
+			if (State.Get(NodeId).Rhs == FLT_MAX)
+			{
+				State.Forget(NodeId);
+				continue;
+			}
+		}
+		TouchedLinks[NumKept++] = Link;
+	}
+	TouchedLinks.SetNum(NumKept, false);
+
+	for (const FSVONavLink& Link : SubtreeLinks)
+	{
+		State.Get(Volume.GetNodeId(Link)).bClosed = false;
+	}
+	return true;
+}
+
+bool FSVONavIncrementalPlanner::ComputeShortestPath()
+{
+	const int32 GoalId = Volume.GetNodeId(GoalLink);
+	FSVONavSearchNode& Goal = Touch(GoalLink, GoalId);
+
+	while (!OpenList.IsEmpty())
+	{
+		if (OpenList.GetTopScore() >= CalculateKey(Goal, GoalLink) && Goal.Rhs == Goal.GScore) break;
+
+		const int32 NodeId = OpenList.GetTopId();
+		const FSVONavLink Link = OpenList.Pop();
+		FSVONavSearchNode& Node = State.Get(NodeId);
+		LastExpansions++;
+
+		Volume.GetSearchNeighbours(Link, Neighbours);
+		if (Node.GScore > Node.Rhs)
+		{
+			// Overconsistent, settle the link and relax its neighbours
+			Node.GScore = Node.Rhs;
+			for (const FSVONavLink& Neighbour : Neighbours)
+			{
+				if (Neighbour == StartLink) continue;
+
+				const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+				FSVONavSearchNode& NeighbourNode = Touch(Neighbour, NeighbourId);
+				const float Score = Node.GScore + Volume.GetTraversalCost(Link, Neighbour, Config);
+				if (Score < NeighbourNode.Rhs)
+				{
+					NeighbourNode.Rhs = Score;
+					NeighbourNode.Parent = Link;
+					UpdateVertex(Neighbour, NeighbourId);
+				}
+			}
+		}
+		else
+		{
+			// Underconsistent, raise the link and re-derive every link that hung off it
+			Node.GScore = FLT_MAX;
+			UpdateRhs(Link, NodeId);
+			UpdateVertex(Link, NodeId);
+			for (const FSVONavLink& Neighbour : Neighbours)
+			{
+				const int32 NeighbourId = Volume.GetNodeId(Neighbour);
+				const FSVONavSearchNode* NeighbourNode = State.Find(NeighbourId);
+				if (!NeighbourNode || NeighbourNode->Parent != Link) continue;
+				UpdateRhs(Neighbour, NeighbourId);
+				UpdateVertex(Neighbour, NeighbourId);
+			}
+		}
+	}
+
+	return Goal.GScore < FLT_MAX;
+}
+
+bool FSVONavIncrementalPlanner::ConfigChanged(const FSVONavPathFindingConfig& InConfig) const
+{
+	return InConfig.Heuristic != Config.Heuristic ||
+		InConfig.NodeSizePreference != Config.NodeSizePreference ||
+		InConfig.UseUnitCost != Config.UseUnitCost ||
+		InConfig.UnitCost != Config.UnitCost;
+}
+
+FSVONavSearchNode& FSVONavIncrementalPlanner::Touch(const FSVONavLink& Link, const int32 NodeId)
+{
+	if (!State.Find(NodeId)) TouchedLinks.Add(Link);
+	return State.Get(NodeId);
+}
+
+void FSVONavIncrementalPlanner::UpdateRhs(const FSVONavLink& Link, const int32 NodeId)
+{
+	if (Link == StartLink) return;
+
+	FSVONavSearchNode& Node = State.Get(NodeId);
+	Node.Rhs = FLT_MAX;
+	Node.Parent = FSVONavLink();
+
+	// Adjacency is not symmetric, the lookahead is over the links that can step into this one
+	Volume.GetSearchPredecessors(Link, RhsNeighbours);
+	for (const FSVONavLink& Neighbour : RhsNeighbours)
+	{
+		const FSVONavSearchNode* Predecessor = State.Find(Volume.GetNodeId(Neighbour));
+		if (!Predecessor || Predecessor->GScore == FLT_MAX) continue;
+
+		const float Score = Predecessor->GScore + Volume.GetTraversalCost(Neighbour, Link, Config);
+		if (Score < Node.Rhs)
+		{
+			Node.Rhs = Score;
+			Node.Parent = Neighbour;
+		}
+	}
+}
+
+void FSVONavIncrementalPlanner::UpdateVertex(const FSVONavLink& Link, const int32 NodeId)
+{
+	const FSVONavSearchNode& Node = State.Get(NodeId);
+	if (Node.GScore != Node.Rhs) OpenList.Update(Link, NodeId, CalculateKey(Node, Link));
+	else OpenList.Remove(NodeId);
+}
+
+float FSVONavIncrementalPlanner::CalculateKey(const FSVONavSearchNode& Node, const FSVONavLink& Link)
+{
+	// Unweighted, an inflated heuristic would let repairs settle links on keys that later turn out too low
+	const float Score = FMath::Min(Node.GScore, Node.Rhs);
+	if (Score == FLT_MAX) return FLT_MAX;
+	return Score + Volume.GetHeuristicScore(Link, GoalLink, TargetCache.Get(Volume, GoalLink), Config);
+}
+
+void FSVONavIncrementalPlanner::BuildPath(const FVector& StartLocation, const FVector& GoalLocation,
+                                          FSVONavPathSharedPtr* Path)
+{
+	if (!Path || !Path->IsValid()) return;
+
+	PathPoints.Reset();
+
+	// Goal back to the root, then reversed. Bounded by the touched count in case a repair left a stale cycle
+	FSVONavLink Link = GoalLink;
+	while (PathPoints.Num() <= TouchedLinks.Num())
+	{
+		FVector Location;
+		Volume.GetLinkLocation(Link, Location);
+		// Same layer numbering as SVONavPathFinder::BuildPath, leaf sub nodes are layer 0
+		const int32 Layer = Link.GetLayerIndex() == 0
+			                    ? (Volume.GetNode(Link).HasChildren() ? 0 : 1)
+			                    : Link.GetLayerIndex() + 1;
+		PathPoints.Emplace(Location, Layer, Link.GetNodeIndex(), true);
+
+		const FSVONavSearchNode* Node = State.Find(Volume.GetNodeId(Link));
+		if (!Node || !Node->Parent.IsValid() || Node->Parent == Link) break;
+		Link = Node->Parent;
+	}
+	Algo::Reverse(PathPoints);
+
+	// If start and goal are in the same voxel, just use the start and goal positions
+	if (PathPoints.Num() == 1)
+	{
+		const FSVONavPathPoint Point = PathPoints[0];
+		PathPoints.Add(Point);
+	}
+	PathPoints[0].Location = StartLocation;
+	PathPoints.Last().Location = GoalLocation;
+
+	Path->Get()->GetPoints().Append(PathPoints);
+}
@@ -0,0 +1,98 @@
+﻿#include "SVONavOpenList.h"
+
+void FSVONavOpenList::Push(const FSVONavLink& Link, const int32 NodeId, const float Score)
+{
+	const int32 Index = State.Get(NodeId).HeapIndex;
+	if (Index != INDEX_NONE)
+	{
+		if (Score < Heap[Index].Score)
+		{
+			Heap[Index].Score = Score;
+			SiftUp(Index);
+		}
+		return;
+	}
+
+	SiftUp(Heap.Add({Link, NodeId, Score}));
+}
+
+FSVONavLink FSVONavOpenList::Pop()
+{
+	const FEntry Top = Heap[0];
+	State.Get(Top.NodeId).HeapIndex = INDEX_NONE;
+
+	const FEntry Last = Heap.Pop(false);
+	if (Heap.Num() > 0)
+	{
+		Place(0, Last);
+		SiftDown(0);
+	}
+	return Top.Link;
+}
+
+void FSVONavOpenList::Update(const FSVONavLink& Link, const int32 NodeId, const float Score)
+{
+	const int32 Index = State.Get(NodeId).HeapIndex;
+	if (Index == INDEX_NONE)
+	{
+		SiftUp(Heap.Add({Link, NodeId, Score}));
+		return;
+	}
+
+	const float OldScore = Heap[Index].Score;
+	Heap[Index].Score = Score;
+	if (Score < OldScore) SiftUp(Index);
+	else SiftDown(Index);
+}
+
+void FSVONavOpenList::Remove(const int32 NodeId)
+{
+	FSVONavSearchNode* Node = State.Find(NodeId);
+	if (!Node || Node->HeapIndex == INDEX_NONE) return;
+
+	const int32 Index = Node->HeapIndex;
+	Node->HeapIndex = INDEX_NONE;
+
+	const FEntry Last = Heap.Pop(false);
+	if (Index < Heap.Num())
+	{
+		Place(Index, Last);
+		SiftUp(Index);
+		SiftDown(State.Get(Last.NodeId).HeapIndex);
+	}
+}
+
+void FSVONavOpenList::Rebuild(TFunctionRef<float(const FSVONavLink& Link, int32 NodeId)> Score)
+{
+	for (FEntry& Entry : Heap) Entry.Score = Score(Entry.Link, Entry.NodeId);
+	for (int32 Index = Heap.Num() / 2 - 1; Index >= 0; Index--) SiftDown(Index);
+}
+
+void FSVONavOpenList::SiftUp(int32 Index)
+{
+	const FEntry Entry = Heap[Index];
+	while (Index > 0)
+	{
+		const int32 ParentIndex = (Index - 1) >> 1;
+		if (Heap[ParentIndex].Score <= Entry.Score) break;
+		Place(Index, Heap[ParentIndex]);
+		Index = ParentIndex;
+	}
+	Place(Index, Entry);
+}
+
+void FSVONavOpenList::SiftDown(int32 Index)
+{
+	const FEntry Entry = Heap[Index];
+	const int32 Count = Heap.Num();
+	while (true)
+	{
+		int32 ChildIndex = (Index << 1) + 1;
+		if (ChildIndex >= Count) break;
+		if (ChildIndex + 1 < Count && Heap[ChildIndex + 1].Score < Heap[ChildIndex].Score) ChildIndex++;
+		if (Entry.Score <= Heap[ChildIndex].Score) break;
+		Place(Index, Heap[ChildIndex]);
+		Index = ChildIndex;
+	}
+	Place(Index, Entry);
+}
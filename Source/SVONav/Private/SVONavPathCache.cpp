@@ -0,0 +1,68 @@
+﻿#include "SVONavPathCache.h"
+
+#include "SVONavVolumeBase.h"
+
+FSVONavPathCacheKey::FSVONavPathCacheKey(const ASVONavVolumeBase& InVolume,
+                                         const FSVONavLink& InStartLink,
+                                         const FSVONavLink& InTargetLink,
+                                         const FSVONavPathFindingConfig& InConfig)
+	: Volume(&InVolume),
+	  StartLink(InStartLink),
+	  TargetLink(InTargetLink),
+	  Config(InConfig),
+	  ConfigHash(InConfig.GetSearchHash())
+{
+}
+
+FSVONavPathCache& FSVONavPathCache::Get()
+{
+	static FSVONavPathCache Cache;
+	return Cache;
+}
+
+FSVONavPathCache::FSVONavPathCache()
+	: Entries(256)
+{
+}
+
+bool FSVONavPathCache::Find(const FSVONavPathCacheKey& Key, const uint32 Revision,
+                            TArray<FSVONavPathPoint>& OutPoints)
+{
+	FScopeLock ScopeLock(&Lock);
+	const FEntry* Entry = Entries.FindAndTouch(Key);
+	if (!Entry) return false;
+
+	// Searched on an older octree, its links may not even exist any more
+	if (Entry->Revision != Revision)
+	{
+		Entries.Remove(Key);
+		return false;
+	}
+
+	OutPoints.Reset();
+	OutPoints.Append(Entry->Points);
+	return true;
+}
+
+void FSVONavPathCache::Add(const FSVONavPathCacheKey& Key, const uint32 Revision,
+                           const TArray<FSVONavPathPoint>& Points)
+{
+	FEntry Entry;
+	Entry.Revision = Revision;
+	Entry.Points = Points;
+
+	FScopeLock ScopeLock(&Lock);
+	Entries.Add(Key, MoveTemp(Entry));
+}
+
+void FSVONavPathCache::Empty(const int32 Capacity)
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty(Capacity > 0 ? Capacity : Entries.Max());
+}
+
+int32 FSVONavPathCache::Num()
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
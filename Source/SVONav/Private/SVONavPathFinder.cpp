@@ -1,12 +1,164 @@
 ﻿#include "SVONavPathFinder.h"
 
 #include "DrawDebugHelpers.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+#include "SVONavPathCache.h"
 #include "SVONav/SVONav.h"
 #include "SVONavVolume.h"
+#include "SVONavVolumeHierarchical.h"
 
 #include "chrono"
 using namespace std::chrono;
 
+namespace
+{
+	// Cells of the 3x3x3 neighbourhood of a leaf cell, and the directions towards them, are numbered by offset
+	constexpr int32 CentreCell = 13;
+
+	FIntVector GetNeighbourhoodOffset(const int32 Index)
+	{
+		return FIntVector(Index % 3 - 1, Index / 3 % 3 - 1, Index / 9 - 1);
+	}
+
+	int32 GetNeighbourhoodIndex(const FIntVector& Offset)
+	{
+		return Offset.X + 1 + (Offset.Y + 1) * 3 + (Offset.Z + 1) * 9;
+	}
+
+	int32 GetAxisCount(const FIntVector& Direction)
+	{
+		return (Direction.X != 0 ? 1 : 0) + (Direction.Y != 0 ? 1 : 0) + (Direction.Z != 0 ? 1 : 0);
+	}
+
+	// True if Direction moves along a subset of the axes of Of, the same way. Of is a sub direction of itself
+	bool IsSubDirection(const FIntVector& Direction, const FIntVector& Of)
+	{
+		return (Direction.X == 0 || Direction.X == Of.X) && (Direction.Y == 0 || Direction.Y == Of.Y) &&
+			(Direction.Z == 0 || Direction.Z == Of.Z);
+	}
+
+	// Neighbourhood cells a step from Cell along Direction needs free, its target and every corner it would cut
+	uint32 GetStepMask(const FIntVector& Cell, const FIntVector& Direction)
+	{
+		uint32 Mask = 0;
+		for (int32 Axes = 1; Axes < 8; Axes++)
+		{
+			const FIntVector Sub(Axes & 1 ? Direction.X : 0, Axes & 2 ? Direction.Y : 0, Axes & 4 ? Direction.Z : 0);
+			if (Sub != FIntVector::ZeroValue) Mask |= 1u << GetNeighbourhoodIndex(Cell + Sub);
+		}
+		return Mask;
+	}
+
+	struct FJumpAlternative
+	{
+		float Cost;
+		int32 Order;
+		uint32 Mask;
+	};
+
+	// Every path of up to three steps from Cell that stays in the neighbourhood and off its centre, by end cell
+	void AddJumpAlternatives(const FIntVector& Cell, const float Cost, const int32 Order, const uint32 Mask,
+	                         const int32 Steps, TArray<FJumpAlternative> (&OutAlternatives)[27])
+	{
+		if (Steps == 3) return;
+		for (int32 E = 0; E < 27; E++)
+		{
+			const FIntVector Step = GetNeighbourhoodOffset(E);
+			const FIntVector Next = Cell + Step;
+			if (E == CentreCell || Next == FIntVector::ZeroValue ||
+				FMath::Abs(Next.X) > 1 || FMath::Abs(Next.Y) > 1 || FMath::Abs(Next.Z) > 1)
+			{
+				continue;
+			}
+
+			// The centre is the jump cell itself and always free, cutting its corner is allowed
+			const float NextCost = Cost + FVector(Step).Size();
+			const int32 NextOrder = Order * 4 + GetAxisCount(Step);
+			const uint32 NextMask = (Mask | GetStepMask(Cell, Step)) & ~(1u << CentreCell);
+			// Orders are padded to three steps, so paths of different lengths compare step by step
+			OutAlternatives[GetNeighbourhoodIndex(Next)].Add({NextCost, NextOrder << 2 * (2 - Steps), NextMask});
+			AddJumpAlternatives(Next, NextCost, NextOrder, NextMask, Steps + 1, OutAlternatives);
+		}
+	}
+
+	/**
+	 * Canonical pruning over the 26 connected leaf cell grid, where diagonal steps never cut a blocked corner.
+	 * A cell X entered along D from its parent P keeps its neighbour N only if no path from P to N around X is cheaper
+	 * than P-X-N, or as cheap and canonically first. Ties break towards steps over more axes first, compared step by
+	 * step, the 3D generalisation of taking the diagonal before the straight step. P-X-N costs at most two 3D
+	 * diagonals, so alternatives of three steps cover every one that can match it.
+	 * Alternatives[D][N] holds the cells each winning alternative needs free, minimal sets only. N is forced when the
+	 * step to it is free and every alternative is obstructed, the sub directions of D are its natural neighbours.
+	 */
+	struct FJumpPointTables
+	{
+		uint32 StepMasks[27];
+		TArray<uint32> Alternatives[27][27];
+
+		FJumpPointTables()
+		{
+			for (int32 E = 0; E < 27; E++)
+			{
+				StepMasks[E] = E == CentreCell ? 0 : GetStepMask(FIntVector::ZeroValue, GetNeighbourhoodOffset(E));
+			}
+
+			TArray<FJumpAlternative> Paths[27];
+			for (int32 D = 0; D < 27; D++)
+			{
+				if (D == CentreCell) continue;
+				const FIntVector Direction = GetNeighbourhoodOffset(D);
+				const FIntVector Parent = Direction * -1;
+				for (TArray<FJumpAlternative>& EndPaths : Paths) EndPaths.Reset();
+				// Stepping back onto the parent is always pruned
+				Paths[GetNeighbourhoodIndex(Parent)].Add({0.f, 0, 0});
+				AddJumpAlternatives(Parent, 0.f, 0, 0, 0, Paths);
+
+				for (int32 E = 0; E < 27; E++)
+				{
+					const FIntVector Neighbour = GetNeighbourhoodOffset(E);
+					if (E == CentreCell || IsSubDirection(Neighbour, Direction)) continue;
+
+					const float Cost = FVector(Direction).Size() + FVector(Neighbour).Size();
+					const int32 Order = (GetAxisCount(Direction) * 4 + GetAxisCount(Neighbour)) * 4;
+					TArray<uint32>& Masks = Alternatives[D][E];
+					for (const FJumpAlternative& Path : Paths[E])
+					{
+						if (Path.Cost < Cost - KINDA_SMALL_NUMBER ||
+							(Path.Cost <= Cost + KINDA_SMALL_NUMBER && Path.Order > Order))
+						{
+							Masks.AddUnique(Path.Mask);
+						}
+					}
+
+					// An alternative needing a superset of another's cells never decides anything
+					Masks.Sort([](const uint32 A, const uint32 B)
+					{
+						return FPlatformMath::CountBits(A) < FPlatformMath::CountBits(B);
+					});
+					for (int32 I = Masks.Num() - 1; I > 0; I--)
+					{
+						for (int32 J = 0; J < I; J++)
+						{
+							if ((Masks[J] & Masks[I]) == Masks[J])
+							{
+								Masks.RemoveAt(I);
+								break;
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	const FJumpPointTables& GetJumpPointTables()
+	{
+		static const FJumpPointTables Tables;
+		return Tables;
+	}
+}
+
 int SVONavPathFinder::FindPath(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink,
                                const FVector& InStartLocation, const FVector& InTargetLocation,
                                FSVONavPathFindingConfig InConfig, FSVONavPathSharedPtr* InPath)
@@ -14,10 +166,24 @@ int SVONavPathFinder::FindPath(const FSVONavLink& InStartLink, const FSVONavLink
 #if WITH_EDITOR
 	const auto StartTime = high_resolution_clock::now();
 #endif
-	int Result;
-	switch (Config.Algorithm)
+	int Result = 0;
+	const bool bHierarchical = Config.Algorithm == ESVONavAlgorithm::HierarchicalAStar ||
+		Config.Algorithm == ESVONavAlgorithm::HierarchicalPortalAStar;
+	const ASVONavVolumeBase& LinkVolume = bHierarchical ? HieVolume : static_cast<ASVONavVolumeBase&>(SVOVolume);
+	const FSVONavPathCacheKey CacheKey(LinkVolume, InStartLink, InTargetLink, InConfig);
+	if (Config.UsePathCache &&
+		FSVONavPathCache::Get().Find(CacheKey, LinkVolume.GetSearchRevision(), InPath->Get()->GetPoints()))
+	{
+		// Keyed by node, so the cached end points only need moving to this request's locations
+		TArray<FSVONavPathPoint>& Points = InPath->Get()->GetPoints();
+		Points[0].Location = InStartLocation;
+		Points.Last().Location = InTargetLocation;
+		Result = 1;
+	}
+	else switch (Config.Algorithm)
 	{
 	case ESVONavAlgorithm::HierarchicalAStar:
+	case ESVONavAlgorithm::HierarchicalPortalAStar:
 		Result = FindPathHierarchical(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
 		break;
 	case ESVONavAlgorithm::GreedyAStar:
@@ -26,6 +192,18 @@ int SVONavPathFinder::FindPath(const FSVONavLink& InStartLink, const FSVONavLink
 	case ESVONavAlgorithm::Testing:
 		Result = FindPathTesting(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
 		break;
+	case ESVONavAlgorithm::JumpPointSearch:
+		Result = FindPathJumpPoint(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
+		break;
+	case ESVONavAlgorithm::BidirectionalAStar:
+		Result = FindPathBidirectional(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
+		break;
+	case ESVONavAlgorithm::LazyThetaStar:
+		Result = FindPathLazyTheta(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
+		break;
+	case ESVONavAlgorithm::AnytimeAStar:
+		Result = FindPathAnytime(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
+		break;
 	default:
 		Result = FindPathHierarchical(InStartLink, InTargetLink, InStartLocation, InTargetLocation, InConfig, InPath);
 		break;
@@ -40,7 +218,13 @@ int SVONavPathFinder::FindPath(const FSVONavLink& InStartLink, const FSVONavLink
 
 	if (Result != 0)
 	{
-		ApplyPathPruning(InPath, InConfig);
+		if (Config.UsePathCache)
+		{
+			FSVONavPathCache::Get().Add(CacheKey, LinkVolume.GetSearchRevision(), InPath->Get()->GetPoints());
+		}
+
+		// Lazy Theta* paths are already any-angle, pruning them again would only add world traces
+		if (Config.Algorithm != ESVONavAlgorithm::LazyThetaStar) ApplyPathPruning(InPath, InConfig);
 		ApplyPathSmoothing(InPath, InConfig);
 	}
 
@@ -52,11 +236,6 @@ int SVONavPathFinder::FindPathHierarchical(const FSVONavLink& InStartLink, const
                                            FSVONavPathFindingConfig InConfig,
                                            FSVONavPathSharedPtr* InPath)
 {
-	OpenSet.Empty();
-	ClosedSet.Empty();
-	Parent.Empty();
-	FScore.Empty();
-	GScore.Empty();
 	CurrentLink = FSVONavLink();
 	TargetLink = InTargetLink;
 	StartLink = InStartLink;
@@ -67,14 +246,15 @@ int SVONavPathFinder::FindPathHierarchical(const FSVONavLink& InStartLink, const
 	FSVONavLink TopTargetLink;
 	TArray<FSVONavLink> StartLinkLevels;
 	TArray<FSVONavLink> TargetLinkLevels;
-	if (!NavComp->DoesPathExistInternal(StartLink,
-	                                    TargetLink,
-	                                    ParentLayer,
-	                                    ParentIndex,
-	                                    TopStartLink,
-	                                    TopTargetLink,
-	                                    StartLinkLevels,
-	                                    TargetLinkLevels))
+	if (!HieVolume.IsReachable(StartLink, TargetLink) ||
+		!NavComp->DoesPathExistInternal(StartLink,
+		                                TargetLink,
+		                                ParentLayer,
+		                                ParentIndex,
+		                                TopStartLink,
+		                                TopTargetLink,
+		                                StartLinkLevels,
+		                                TargetLinkLevels))
 	{
 #if WITH_EDITOR
 		UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, no path exist"));
@@ -96,35 +276,24 @@ int SVONavPathFinder::FindPathHierarchical(const FSVONavLink& InStartLink, const
 	TopStartLink = StartLinkLevels[SearchLevel];
 	TopTargetLink = TargetLinkLevels[SearchLevel];
 	
-	OpenSet.Add(TopStartLink);
-	Parent.Add(TopStartLink, TopStartLink);
-	GScore.Add(TopStartLink, 0);
-	FScore.Add(TopStartLink, HeuristicScoreHie(TopStartLink, TopTargetLink)); // Distance to target
+	BeginSearch(HieVolume, TopStartLink, HeuristicScoreHie(TopStartLink, TopTargetLink)); // Distance to target
+
+	// Portal search only expands region portals, interior links are filled back in from the region tables
+	PortalVolume = Config.Algorithm == ESVONavAlgorithm::HierarchicalPortalAStar
+		               ? Cast<ASVONavVolumeHierarchical>(&HieVolume)
+		               : nullptr;
 
 	int numIterations = 0;
 
-	while (OpenSet.Num() > 0)
+	while (!OpenList.IsEmpty())
 	{
-		//get lowest score link
-		float lowestScore = FLT_MAX;
-		for (FSVONavLink& link : OpenSet)
-		{
-			if (!FScore.Contains(link) || FScore[link] < lowestScore)
-			{
-				lowestScore = FScore[link];
-				CurrentLink = link;
-			}
-		}
-
-		//explored link, remove from openset and added to closedset
-		OpenSet.Remove(CurrentLink);
-		ClosedSet.Add(CurrentLink);
+		//get lowest score link, remove from open list and added to closedset
+		PopCurrent();
 
 		// confirm path found
 		if (CurrentLink == TopTargetLink)
 		{
-			BuildHierarchicalPath(Parent,
-			                      TopStartLink,
+			BuildHierarchicalPath(TopStartLink,
 			                      TopTargetLink,
 			                      StartLink,
 			                      TargetLink,
@@ -136,8 +305,16 @@ int SVONavPathFinder::FindPathHierarchical(const FSVONavLink& InStartLink, const
 			return numIterations;
 		}
 
+		if (PortalVolume)
+		{
+			ExpandPortalLink(TopTargetLink);
+			numIterations++;
+			continue;
+		}
+
 		//get all neighbour links of node that current link point to
-		TArray<FSVONavLink> neighbours;
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		neighbours.Reset();
 		HieVolume.GetNeighbourLinks(CurrentLink, neighbours);
 
 		//check each links if they has been explored, score and add to set
@@ -154,8 +331,43 @@ int SVONavPathFinder::FindPathHierarchical(const FSVONavLink& InStartLink, const
 	return 0;
 }
 
-void SVONavPathFinder::BuildHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InParent,
-                                             FSVONavLink TopStartLink,
+void SVONavPathFinder::ExpandPortalLink(const FSVONavLink& InTargetLink)
+{
+	const FSVONavNode& Node = HieVolume.GetNode(CurrentLink);
+	const FSVONavRegionTable* Region = PortalVolume->GetRegionTable(Node.Parent);
+	const int32 From = Region ? PortalVolume->GetRegionMemberIndex(CurrentLink) : INDEX_NONE;
+
+	// Cross the region on its cached routes, stopping only at portals and the target
+	if (From != INDEX_NONE)
+	{
+		const float LayerScale = 1.0f - static_cast<float>(CurrentLink.GetLayerIndex()) /
+			static_cast<float>(HieVolume.NumLayers) * Config.NodeSizePreference;
+		for (int32 To = 0; To < Region->Members.Num(); To++)
+		{
+			const FSVONavLink& Member = Region->Members[To];
+			if (To == From || !(Region->IsPortal[To] || Member == InTargetLink)) continue;
+			if (Region->GetCost(From, To) == FLT_MAX) continue;
+
+			// Unit costs still pay the cost field of every member entered along the cached route
+			float Cost = Config.UseUnitCost ? 0.f : Region->GetCost(From, To);
+			for (int32 Hop = From; Config.UseUnitCost && Hop != To;)
+			{
+				Hop = Region->GetNextHop(Hop, To);
+				Cost += Config.UnitCost * HieVolume.GetCostScale(Region->Members[Hop]);
+			}
+			ProcessLinkHie(Member, Cost * LayerScale);
+		}
+	}
+
+	// Leave the region over direct links
+	for (const FSVONavLink& Neighbour : Node.NeighbourSet)
+	{
+		if (From != INDEX_NONE && Region->Members.Contains(Neighbour)) continue;
+		ProcessLinkHie(Neighbour);
+	}
+}
+
+void SVONavPathFinder::BuildHierarchicalPath(FSVONavLink TopStartLink,
                                              FSVONavLink TopTargetLink,
                                              FSVONavLink InStartLink,
                                              FSVONavLink InTargetLink,
@@ -166,7 +378,8 @@ void SVONavPathFinder::BuildHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InP
 {
 	FSVONavPathPoint Location;
 
-	TArray<FSVONavPathPoint> Points;
+	TArray<FSVONavPathPoint>& Points = Context.PathPoints;
+	Points.Reset();
 
 	if (!InPath || !InPath->IsValid())
 		return;
@@ -176,15 +389,27 @@ void SVONavPathFinder::BuildHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InP
 	Points[0].Layer = InCurrentLink.GetLayerIndex();
 	Points[0].Index = InCurrentLink.GetNodeIndex();*/
 	
-	while (InParent.Contains(InCurrentLink) && !(InCurrentLink == InParent[InCurrentLink]))
+	const auto InsertPoint = [this, &Points, &Location](const FSVONavLink& Link)
 	{
-		//InCurrentLink = InParent[InCurrentLink];
-		HieVolume.GetLinkLocation(InCurrentLink, Location.Location);
+		HieVolume.GetLinkLocation(Link, Location.Location);
 		Points.Insert(Location, 0);
 
-		Points[0].Layer = InCurrentLink.GetLayerIndex();
-		Points[0].Index = InCurrentLink.GetNodeIndex();
-		InCurrentLink = InParent[InCurrentLink];
+		Points[0].Layer = Link.GetLayerIndex();
+		Points[0].Index = Link.GetNodeIndex();
+	};
+
+	FSVONavLink ParentLink;
+	TArray<FSVONavLink>& Route = Context.Neighbours;
+	while (GetParentLink(HieVolume, InCurrentLink, ParentLink))
+	{
+		InsertPoint(InCurrentLink);
+		// Portal search steps across regions, put back the interior links of the cached route
+		if (PortalVolume)
+		{
+			PortalVolume->GetRegionRoute(ParentLink, InCurrentLink, Route);
+			for (int32 I = Route.Num() - 1; I >= 0; I--) InsertPoint(Route[I]);
+		}
+		InCurrentLink = ParentLink;
 	}
 	/*if (Points.Num() > 1)
 	{
@@ -231,114 +456,128 @@ void SVONavPathFinder::BuildHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InP
 		       Points[i].Refined? TEXT("true") : TEXT("false"));
 	}
 
-	TArray<FSVONavPathPoint> PathPoints = InPath->Get()->GetPoints();
-	RefineHierarchicalPath(PathPoints[0].GetLink(), PathPoints[1].GetLink(), InPath, 0);
+	RefineHierarchicalPath(InPath);
+}
+
+void SVONavPathFinder::RefineHierarchicalPath(FSVONavPathSharedPtr* InPath)
+{
+	TArray<FSVONavPathPoint>& PathPoints = InPath->Get()->GetPoints();
+	TArray<int32>& Segments = Context.RefineSegments;
+	TArray<TArray<FSVONavPathPoint>>& SegmentPoints = Context.SegmentPoints;
+	TArray<FSVONavPathPoint>& Spliced = Context.SplicedPoints;
 
-	PathPoints = InPath->Get()->GetPoints();
-	//RefineHierarchicalPath(PathPoints[0].GetLink(), PathPoints[1].GetLink(), InPath, 0);
-	/*bool Refined = false;s
-	while (!Refined)
+	// Each pass takes the unrefined points one layer down, so the layer count bounds the passes
+	for (int32 Pass = 0; Pass <= HieVolume.NumLayers; Pass++)
 	{
-		bool FoundUnrefinedPoint = false;
-		TArray<FSVONavPathPoint> PathPoints = InPath->Get()->GetPoints();
-		for(int32 I = 1; I < PathPoints.Num(); I ++)
+		// Pin every unrefined point to one of its children first, the segments either side then agree on the joint
+		Segments.Reset();
+		for (int32 I = 1; I < PathPoints.Num() - 1; I++)
 		{
-			if(!PathPoints[I].Refined)
-			{
-				FoundUnrefinedPoint = true;
-				RefineHierarchicalPath(PathPoints[I-1].GetLink(), PathPoints[I].GetLink(), InPath, I-1);
-				break;
-			}
+			if (PathPoints[I].Refined) continue;
+			PathPoints[I] = GetJointPoint(PathPoints[I - 1], PathPoints[I], PathPoints[I + 1]);
+			if (Segments.Num() == 0 || Segments.Last() != I - 1) Segments.Add(I - 1);
+			Segments.Add(I);
 		}
-s
-		if(FoundUnrefinedPoint) continue;
-		Refined = true;
-	}*/
-	/*TArray<FSVONavPathPoint> PostPath = InPath->Get()->GetPoints();
-	RefineHierarchicalPath(PostPath[PostPath.Num()-2].GetLink(), PostPath[PostPath.Num()-1].GetLink(), InPath, PostPath.Num()-2);
-
-	Refined = false;
-	while (!Refined)
-	{
-		bool FoundUnrefinedPoint = false;
-		TArray<FSVONavPathPoint> PathPoints = InPath->Get()->GetPoints();
-		for(int32 I = 1; I < PathPoints.Num(); I ++)
+		if (Segments.Num() == 0) break;
+
+		// Segments are independent once their ends are pinned, each searches on its own pooled context
+		if (SegmentPoints.Num() < Segments.Num()) SegmentPoints.SetNum(Segments.Num());
+		ParallelFor(Segments.Num(), [this, &PathPoints, &Segments, &SegmentPoints](const int32 S)
 		{
-			if(!PathPoints[I].Refined)
-			{
-				FoundUnrefinedPoint = true;
-				RefineHierarchicalPath(PathPoints[I-1].GetLink(), PathPoints[I].GetLink(), InPath, I-1);
-				break;
-			}
+			SVONavPathFinder SegmentFinder(World, NavComp, SVOVolume, HieVolume, Config);
+			SegmentFinder.RefineHierarchicalSegment(PathPoints[Segments[S]].GetLink(),
+			                                        PathPoints[Segments[S] + 1].GetLink(),
+			                                        SegmentPoints[S]);
+		});
+
+		// Splice the segment interiors in after their start points, the buffers are swapped rather than copied
+		Spliced.Reset();
+		for (int32 I = 0, S = 0; I < PathPoints.Num(); I++)
+		{
+			Spliced.Add(PathPoints[I]);
+			if (S < Segments.Num() && Segments[S] == I) Spliced.Append(SegmentPoints[S++]);
 		}
+		Swap(PathPoints, Spliced);
+	}
+
+#if WITH_EDITOR
+	if (NavComp->bDebugLogPathfinding) UE_LOG(LogSVONav, Display, TEXT("Hierarchical path refined, Num of total Point: %i"),
+	                                          PathPoints.Num());
+#endif
+}
+
+FSVONavPathPoint SVONavPathFinder::GetJointPoint(const FSVONavPathPoint& Previous,
+                                                 const FSVONavPathPoint& Point,
+                                                 const FSVONavPathPoint& Next) const
+{
+	// The child closest to the way through keeps detours around the parent short
+	FSVONavLink Joint;
+	float BestDistance = FLT_MAX;
+	for (const FSVONavLink& Child : HieVolume.GetNode(Point.GetLink()).Children)
+	{
+		const FVector Centre = HieVolume.GetLinkCentre(Child);
+		const float Distance = FVector::Dist(Centre, Previous.Location) + FVector::Dist(Centre, Next.Location);
+		if (Distance >= BestDistance) continue;
+		BestDistance = Distance;
+		Joint = Child;
+	}
+
+	if (!Joint.IsValid())
+	{
+		FSVONavPathPoint Refined = Point;
+		Refined.Refined = true;
+		return Refined;
+	}
 
-		if(FoundUnrefinedPoint) continue;
-		Refined = true;
-	}*/
+	FVector Location;
+	HieVolume.GetLinkLocation(Joint, Location);
+	return FSVONavPathPoint(Location,
+	                        Joint.GetLayerIndex(),
+	                        Joint.GetNodeIndex(),
+	                        HieVolume.GetNode(Joint).HasChildren() ? false : true);
 }
 
-int SVONavPathFinder::RefineHierarchicalPath(FSVONavLink InStartLink, FSVONavLink InTargetLink,
-                                             FSVONavPathSharedPtr* InPath, int32 RefineIndex)
+bool SVONavPathFinder::RefineHierarchicalSegment(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink,
+                                                 TArray<FSVONavPathPoint>& OutPoints)
 {
-	TargetSet.Empty();
-	OpenSet.Empty();
-	ClosedSet.Empty();
-	Parent.Empty();
-	FScore.Empty();
-	GScore.Empty();
+	if (StitchRegionRoute(InStartLink, InTargetLink, OutPoints)) return true;
+
+	OutPoints.Reset();
 	CurrentLink = FSVONavLink();
 	StartLink = InStartLink;
 	TargetLink = InTargetLink;
-	const FSVONavNode& TargetNode = HieVolume.GetNode(TargetLink);
-
-	if (TargetNode.HasChildren()) for (auto& Child : TargetNode.Children)TargetSet.Add(Child);
-	else TargetSet.Add(InTargetLink);
 
-	OpenSet.Add(StartLink);
-	Parent.Add(StartLink, StartLink);
-	GScore.Add(StartLink, 0);
-	FScore.Add(StartLink, HeuristicScoreHie(StartLink, TargetLink)); // Distance to target
+	BeginSearch(HieVolume, StartLink, HeuristicScoreHie(StartLink, TargetLink)); // Distance to target
 
 	int numIterations = 0;
 
-	while (OpenSet.Num() > 0)
+	while (!OpenList.IsEmpty())
 	{
-		//get lowest score link
-		float lowestScore = FLT_MAX;
-		for (FSVONavLink& link : OpenSet)
+		//get lowest score link, remove from open list and added to closedset
+		PopCurrent();
+
+		// confirm path found, only the links between start and target are handed back
+		if (CurrentLink == TargetLink)
 		{
-			if (!FScore.Contains(link) || FScore[link] < lowestScore)
+			FSVONavLink Link = CurrentLink;
+			FSVONavLink ParentLink;
+			while (GetParentLink(HieVolume, Link, ParentLink) && ParentLink != StartLink)
 			{
-				lowestScore = FScore[link];
-				CurrentLink = link;
+				Link = ParentLink;
+				FVector Location;
+				HieVolume.GetLinkLocation(Link, Location);
+				OutPoints.Emplace(Location,
+				                  Link.GetLayerIndex(),
+				                  Link.GetNodeIndex(),
+				                  HieVolume.GetNode(Link).HasChildren() ? false : true);
 			}
-		}
-
-		//explored link, remove from openset and added to closedset
-		OpenSet.Remove(CurrentLink);
-		ClosedSet.Add(CurrentLink);
-
-		// confirm path found
-		if (TargetSet.Contains(CurrentLink))
-		{
-			FVector TargetLocation;
-			HieVolume.GetLinkLocation(CurrentLink, TargetLocation);
-			RollHierarchicalPath(Parent,
-			                     CurrentLink,
-			                     StartLink,
-			                     CurrentLink,
-			                     InPath->Get()->GetPoints()[RefineIndex].Location,
-			                     TargetLocation,
-			                     InPath,
-			                     RefineIndex);
-#if WITH_EDITOR
-			UE_LOG(LogSVONav, Display, TEXT("Path Rolling success, number of Iteration: %i"), numIterations);
-#endif
-			return 1;
+			Algo::Reverse(OutPoints);
+			return true;
 		}
 
 		//get all neighbour links of node that current link point to
-		TArray<FSVONavLink> neighbours;
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		neighbours.Reset();
 		HieVolume.GetNeighbourLinks(CurrentLink, neighbours);
 
 		//check each links if they has been explored, score and add to set
@@ -350,81 +589,88 @@ int SVONavPathFinder::RefineHierarchicalPath(FSVONavLink InStartLink, FSVONavLin
 		numIterations++;
 	}
 #if WITH_EDITOR
-	UE_LOG(LogSVONav, Display, TEXT("Path Rolling fail, can't find refined path: number of Iteration: %i"),
-	       numIterations);
+	if (NavComp->bDebugLogPathfinding) UE_LOG(LogSVONav, Display,
+	                                          TEXT("Segment refinement fail, can't find refined path: number of Iteration: %i"),
+	                                          numIterations);
 #endif
-	return 0;
+	return false;
 }
 
-void SVONavPathFinder::RollHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InParent,
-                                            FSVONavLink InCurrentLink,
-                                            FSVONavLink InStartLink,
-                                            FSVONavLink InTargetLink,
-                                            const FVector& InStartLocation,
-                                            const FVector& InTargetLocation,
-                                            FSVONavPathSharedPtr* InPath,
-                                            int32& PointIndex)
+bool SVONavPathFinder::StitchRegionRoute(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink,
+                                         TArray<FSVONavPathPoint>& OutPoints) const
 {
-	FSVONavPathPoint Location;
+	OutPoints.Reset();
+	const ASVONavVolumeHierarchical* Regions = Cast<ASVONavVolumeHierarchical>(&HieVolume);
+	if (!Regions || InStartLink.GetLayerIndex() != InTargetLink.GetLayerIndex()) return false;
 
-	TArray<FSVONavPathPoint> Points;
+	const FSVONavLink& StartParent = HieVolume.GetNode(InStartLink).Parent;
+	const FSVONavLink& TargetParent = HieVolume.GetNode(InTargetLink).Parent;
+	const FSVONavRegionTable* StartRegion = Regions->GetRegionTable(StartParent);
+	const FSVONavRegionTable* TargetRegion = Regions->GetRegionTable(TargetParent);
+	if (!StartRegion || !TargetRegion) return false;
 
-	if (!InPath || !InPath->IsValid())
-		return;
+	const int32 Start = Regions->GetRegionMemberIndex(InStartLink);
+	const int32 Target = Regions->GetRegionMemberIndex(InTargetLink);
+	if (Start == INDEX_NONE || Target == INDEX_NONE) return false;
 
-	while (InParent.Contains(InCurrentLink) && !(InCurrentLink == InParent[InCurrentLink]))
+	const auto AddPoint = [this, &OutPoints](const FSVONavLink& Link)
 	{
-		InCurrentLink = InParent[InCurrentLink];
-		HieVolume.GetLinkLocation(InCurrentLink, Location.Location);
-		Points.Insert(Location, 0);
-
-		Points[0].Layer = InCurrentLink.GetLayerIndex();
-		Points[0].Index = InCurrentLink.GetNodeIndex();
-		Points[0].Refined = HieVolume.GetNode(InCurrentLink).HasChildren() ? false : true;
-	}
-
-	TArray<FSVONavPathPoint> PathPoints = InPath->Get()->GetPoints();
-
-	// If start and end are in the same voxel, just use the start and target positions.
-	if (Points.Num() > 1)
+		FVector Location;
+		HieVolume.GetLinkLocation(Link, Location);
+		OutPoints.Emplace(Location,
+		                  Link.GetLayerIndex(),
+		                  Link.GetNodeIndex(),
+		                  HieVolume.GetNode(Link).HasChildren() ? false : true);
+	};
+	const auto AddRoute = [Regions, &AddPoint](const FSVONavLink& From, const FSVONavLink& To)
 	{
-		//first point always contain lowest level link info
-		Points[0].Location = InStartLocation;
-		Points[0].Layer = InStartLink.LayerIndex;
-		Points[0].Index = InStartLink.NodeIndex;
+		TArray<FSVONavLink> Route;
+		Regions->GetRegionRoute(From, To, Route);
+		for (const FSVONavLink& Link : Route) AddPoint(Link);
+	};
 
-		int32 Index = Points.Emplace();
-		Points[Index].Location = InTargetLocation;
-		Points[Index].Layer = InTargetLink.LayerIndex;
-		Points[Index].Index = InTargetLink.NodeIndex,
-			Points[Index].Refined = HieVolume.GetNode(InTargetLink).HasChildren() ? false : true;
-	}
-	else if (Points.Num() == 0)
+	// Both ends in one region, its table already holds the whole route
+	if (StartParent == TargetParent)
 	{
-		Points.Emplace(InStartLocation,
-		               InStartLink.GetLayerIndex(),
-		               InStartLink.GetNodeIndex(),
-		               HieVolume.GetNode(InStartLink).HasChildren() ? false : true);
-
-		Points.Emplace(InTargetLocation,
-		               InTargetLink.GetLayerIndex(),
-		               InTargetLink.GetNodeIndex(),
-		               HieVolume.GetNode(InTargetLink).HasChildren() ? false : true);
+		if (StartRegion->GetCost(Start, Target) == FLT_MAX) return false;
+		AddRoute(InStartLink, InTargetLink);
+		return true;
 	}
-	PathPoints.Insert(Points, PointIndex + 1);
-	PathPoints.RemoveAt(PointIndex + Points.Num() + 1);
-	PathPoints.RemoveAt(PointIndex);
 
-	InPath->Get()->Empty();
-	for (int i = 0; i < PathPoints.Num(); i++)
+	// Adjacent regions, cross over the cheapest pair of linked portals
+	FSVONavLink ExitLink;
+	FSVONavLink EntryLink;
+	float BestCost = FLT_MAX;
+	for (int32 Exit = 0; Exit < StartRegion->Members.Num(); Exit++)
 	{
-		InPath->Get()->GetPoints().Add(PathPoints[i]);
+		const float ExitCost = StartRegion->GetCost(Start, Exit);
+		if (!StartRegion->IsPortal[Exit] || ExitCost == FLT_MAX) continue;
+
+		const FSVONavLink& Portal = StartRegion->Members[Exit];
+		for (const FSVONavLink& Neighbour : HieVolume.GetNode(Portal).NeighbourSet)
+		{
+			if (!HieVolume.LinkNodeIsValid(Neighbour) || HieVolume.GetNode(Neighbour).Parent != TargetParent) continue;
+
+			const int32 Entry = Regions->GetRegionMemberIndex(Neighbour);
+			if (Entry == INDEX_NONE || TargetRegion->GetCost(Entry, Target) == FLT_MAX) continue;
+
+			// Same edge weights as the region tables
+			const float Cost = ExitCost + TargetRegion->GetCost(Entry, Target) +
+				(HieVolume.GetLinkCentre(Neighbour) - HieVolume.GetLinkCentre(Portal)).Size() *
+				HieVolume.GetCostScale(Neighbour);
+			if (Cost >= BestCost) continue;
+			BestCost = Cost;
+			ExitLink = Portal;
+			EntryLink = Neighbour;
+		}
 	}
+	if (BestCost == FLT_MAX) return false;
 
-#if WITH_EDITOR
-	UE_LOG(LogSVONav, Display, TEXT("Path Rolling finish, Num of total Point: %i, Point added %i"), PathPoints.Num(),
-	       Points.Num()-2);
-#endif
+	AddRoute(InStartLink, ExitLink);
+	if (ExitLink != InStartLink) AddPoint(ExitLink);
+	if (EntryLink != InTargetLink) AddPoint(EntryLink);
+	AddRoute(EntryLink, InTargetLink);
+	return true;
 }
 
 int SVONavPathFinder::FindPathTesting(const FSVONavLink& InStartLink,
@@ -435,38 +681,24 @@ int SVONavPathFinder::FindPathTesting(const FSVONavLink& InStartLink,
                                       FSVONavPathSharedPtr* InPath)
 {
 	// Initialise
-	TMap<FSVONavLink, float> G;
-	TMap<FSVONavLink, float> F;
-	FSVONavLink CurrentEdge = FSVONavLink();
-	InPath->Get()->Empty();
+	InPath->Get()->Reset();
 
 	// Greedy A*
-	OpenSet.Add(InStartLink);
-	Parent.Add(InStartLink, InStartLink);
-	G.Add(InStartLink, 0);
-	F.Add(InStartLink, HeuristicScore(InStartLink, InTargetLink));
+	BeginSearch(SVOVolume, InStartLink, HeuristicScore(InStartLink, InTargetLink));
 	int32 I = 0;
-	while (OpenSet.Num() > 0)
+	while (!OpenList.IsEmpty())
 	{
-		float LowestScore = FLT_MAX;
-		for (FSVONavLink& Edge : OpenSet)
-		{
-			if (!F.Contains(Edge) || F[Edge] < LowestScore)
-			{
-				LowestScore = F[Edge];
-				CurrentEdge = Edge;
-			}
-		}
-		OpenSet.Remove(CurrentEdge);
-		ClosedSet.Add(CurrentEdge);
+		PopCurrent();
+		FSVONavLink CurrentEdge = CurrentLink;
 
 		if (CurrentEdge.NodeIndex == InTargetLink.NodeIndex)
 		{
 			FSVONavPathPoint PathPoint;
 
-			while (Parent.Contains(CurrentEdge) && !(CurrentEdge == Parent[CurrentEdge]))
+			FSVONavLink ParentEdge;
+			while (GetParentLink(SVOVolume, CurrentEdge, ParentEdge))
 			{
-				CurrentEdge = Parent[CurrentEdge];
+				CurrentEdge = ParentEdge;
 				SVOVolume.GetLinkLocation(CurrentEdge, PathPoint.Location);
 				InPath->Get()->Points.Insert(PathPoint, 0);
 				const FSVONavNode& Node = SVOVolume.GetNode(CurrentEdge);
@@ -500,7 +732,8 @@ int SVONavPathFinder::FindPathTesting(const FSVONavLink& InStartLink,
 		}
 
 		const FSVONavNode& CurrentNode = SVOVolume.GetNode(CurrentEdge);
-		TArray<FSVONavLink> AdjacentEdges;
+		TArray<FSVONavLink>& AdjacentEdges = Context.Neighbours;
+		AdjacentEdges.Reset();
 
 		if (CurrentEdge.GetLayerIndex() == 0 && CurrentNode.FirstChild.IsValid())
 		{
@@ -515,42 +748,32 @@ int SVONavPathFinder::FindPathTesting(const FSVONavLink& InStartLink,
 		{
 			if (AdjacentEdge.IsValid())
 			{
-				if (ClosedSet.Contains(AdjacentEdge))
+				const int32 AdjacentId = SVOVolume.GetNodeId(AdjacentEdge);
+				FSVONavSearchNode& Adjacent = SearchState.Get(AdjacentId);
+				if (Adjacent.bClosed)
 				{
 					continue;
 				}
-				if (!OpenSet.Contains(AdjacentEdge))
-				{
-					OpenSet.Add(AdjacentEdge);
-				}
 
-				float MinGScore = FLT_MAX;
-				if (G.Contains(CurrentEdge))
-				{
-					FVector CurrentLocation(0.f), AdjacentLocation(0.f);
-					SVOVolume.GetLinkLocation(CurrentEdge, CurrentLocation);
-					SVOVolume.GetLinkLocation(AdjacentEdge, AdjacentLocation);
-					float Cost = 0.0f;
-
-					Cost -= static_cast<float>(InTargetLink.GetLayerIndex()) / static_cast<float>(SVOVolume.NumLayers) *
-						Config.NodeSizePreference;
-					if (Config.Heuristic == ESVONavHeuristic::Euclidean)
-					{
-						Cost *= (CurrentLocation - AdjacentLocation).Size();
-					}
-					MinGScore = G[CurrentEdge] + Cost;
-				}
-				else
+				FVector CurrentLocation(0.f), AdjacentLocation(0.f);
+				SVOVolume.GetLinkLocation(CurrentEdge, CurrentLocation);
+				SVOVolume.GetLinkLocation(AdjacentEdge, AdjacentLocation);
+				float Cost = 0.0f;
+
+				Cost -= static_cast<float>(InTargetLink.GetLayerIndex()) / static_cast<float>(SVOVolume.NumLayers) *
+					Config.NodeSizePreference;
+				if (Config.Heuristic == ESVONavHeuristic::Euclidean)
 				{
-					G.Add(CurrentEdge, FLT_MAX);
+					Cost *= (CurrentLocation - AdjacentLocation).Size();
 				}
+				const float MinGScore = SearchState.Get(CurrentId).GScore + Cost;
 
-				if (MinGScore >= (G.Contains(AdjacentEdge) ? G[AdjacentEdge] : FLT_MAX)) continue;
-				Parent.Add(AdjacentEdge, CurrentEdge);
-				G.Add(AdjacentEdge, MinGScore);
+				if (MinGScore >= Adjacent.GScore) continue;
+				Adjacent.Parent = CurrentEdge;
+				Adjacent.GScore = MinGScore;
 				// Greedy A* multiplies the heuristic score by the estimate weight
-				F.Add(AdjacentEdge,
-				      G[AdjacentEdge] + Config.EstimateWeight * HeuristicScore(AdjacentEdge, InTargetLink));
+				Adjacent.FScore = MinGScore + Config.EstimateWeight * HeuristicScore(AdjacentEdge, InTargetLink);
+				OpenList.Push(AdjacentEdge, AdjacentId, Adjacent.FScore);
 			}
 		}
 		I++;
@@ -569,100 +792,854 @@ int SVONavPathFinder::FindPathAStar(const FSVONavLink& InStartLink,
                                     FSVONavPathFindingConfig InConfig,
                                     FSVONavPathSharedPtr* InPath)
 {
-	OpenSet.Empty();
+	BeginAStar(InStartLink, InTargetLink);
+	if (StepAStar(0, 0.0, InStartLocation, InTargetLocation, InPath) == ESVONavPathQueryStatus::Succeeded)
+	{
+		return Expansions;
+	}
+#if WITH_EDITOR
+	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), Expansions);
+#endif
+	return 0;
+}
 
-	ClosedSet.Empty();
-	Parent.Empty();
-	FScore.Empty();
-	GScore.Empty();
+void SVONavPathFinder::BeginAStar(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
+{
 	CurrentLink = FSVONavLink();
 	TargetLink = InTargetLink;
 	StartLink = InStartLink;
+	Expansions = 0;
 
-	OpenSet.Add(InStartLink);
-	Parent.Add(InStartLink, InStartLink);
-	GScore.Add(InStartLink, 0);
-	FScore.Add(InStartLink, HeuristicScore(InStartLink, TargetLink)); // Distance to target
+	BeginSearch(SVOVolume, InStartLink, HeuristicScore(InStartLink, TargetLink)); // Distance to target
+}
 
-	int numIterations = 0;
+ESVONavPathQueryStatus SVONavPathFinder::StepAStar(const int32 MaxExpansions, const double EndTime,
+                                                   const FVector& InStartLocation,
+                                                   const FVector& InTargetLocation,
+                                                   FSVONavPathSharedPtr* InPath)
+{
+	const int32 ExpansionLimit = MaxExpansions > 0 ? Expansions + MaxExpansions : MAX_int32;
+	int32 SliceExpansions = 0;
 
-	while (OpenSet.Num() > 0)
+	while (!OpenList.IsEmpty())
 	{
-		float lowestScore = FLT_MAX;
-		for (FSVONavLink& link : OpenSet)
+		if (Expansions >= ExpansionLimit) return ESVONavPathQueryStatus::InProgress;
+		// Timer is polled every 16 expansions, a microsecond budget can overrun by that much
+		if (EndTime > 0.0 && (++SliceExpansions & 15) == 0 && FPlatformTime::Seconds() > EndTime)
 		{
-			if (!FScore.Contains(link) || FScore[link] < lowestScore)
-			{
-				lowestScore = FScore[link];
-				CurrentLink = link;
-			}
+			return ESVONavPathQueryStatus::InProgress;
 		}
 
-		OpenSet.Remove(CurrentLink);
-
-		ClosedSet.Add(CurrentLink);
+		PopCurrent();
 
 		if (CurrentLink == TargetLink)
 		{
-			BuildPath(Parent, CurrentLink, InStartLocation, InTargetLocation, InPath);
-			return numIterations;
+			if (InPath) BuildPath(CurrentLink, InStartLocation, InTargetLocation, InPath);
+			return ESVONavPathQueryStatus::Succeeded;
 		}
 
-		const FSVONavNode& currentNode = SVOVolume.GetNode(CurrentLink);
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
 
-		TArray<FSVONavLink> neighbours;
-
-		if (CurrentLink.GetLayerIndex() == 0 && currentNode.FirstChild.IsValid())
+		for (const FSVONavLink& neighbour : neighbours)
 		{
-			SVOVolume.GetNeighbourLeaves(CurrentLink, neighbours);
+			ProcessLink(neighbour);
 		}
-		else
+
+		Expansions++;
+	}
+	return ESVONavPathQueryStatus::Failed;
+}
+
+int SVONavPathFinder::FindPathToNearest(const FSVONavLink& InStartLink,
+                                        const TArray<FSVONavLink>& InTargetLinks,
+                                        const FVector& InStartLocation,
+                                        const TArray<FVector>& InTargetLocations,
+                                        FSVONavPathSharedPtr* InPath,
+                                        int32& OutTargetIndex)
+{
+	OutTargetIndex = INDEX_NONE;
+	if (InTargetLocations.Num() != InTargetLinks.Num()) return 0;
+
+	// Goals are only popped in order of travel cost under an admissible estimate, the search runs on its own copy
+	// of the config rather than the caller's
+	FSVONavPathFindingConfig NearestConfig = GetAdmissibleConfig(InTargetLinks);
+	SVONavPathFinder NearestFinder(World, NavComp, SVOVolume, HieVolume, NearestConfig);
+	return NearestFinder.SearchNearest(InStartLink, InTargetLinks, InStartLocation, InTargetLocations, InPath,
+	                                   OutTargetIndex);
+}
+
+int SVONavPathFinder::SearchNearest(const FSVONavLink& InStartLink,
+                                    const TArray<FSVONavLink>& InTargetLinks,
+                                    const FVector& InStartLocation,
+                                    const TArray<FVector>& InTargetLocations,
+                                    FSVONavPathSharedPtr* InPath,
+                                    int32& OutTargetIndex)
+{
+	CurrentLink = FSVONavLink();
+	StartLink = InStartLink;
+	TargetSet.Reset();
+	for (const FSVONavLink& Link : InTargetLinks)
+	{
+		if (Link.IsValid()) TargetSet.Add(Link);
+	}
+	if (TargetSet.Num() == 0) return 0;
+
+	BeginSearch(SVOVolume, InStartLink, NearestHeuristicScore(InStartLink, InTargetLinks));
+
+	int numIterations = 0;
+
+	while (!OpenList.IsEmpty())
+	{
+		PopCurrent();
+
+		// The first target popped is the nearest by path, the estimate never overshoots any of them
+		if (TargetSet.Contains(CurrentLink))
 		{
-			SVOVolume.GetNeighbourLinks(CurrentLink, neighbours);
+			OutTargetIndex = InTargetLinks.IndexOfByKey(CurrentLink);
+			BuildPath(CurrentLink, InStartLocation, InTargetLocations[OutTargetIndex], InPath);
+			ApplyPathPruning(InPath, Config);
+			ApplyPathSmoothing(InPath, Config);
+			return numIterations + 1;
 		}
 
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
+
 		for (const FSVONavLink& neighbour : neighbours)
 		{
-			ProcessLink(neighbour);
+			if (!neighbour.IsValid()) continue;
+
+			const int32 NeighbourId = SVOVolume.GetNodeId(neighbour);
+			FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
+			if (Neighbour.bClosed) continue;
+
+			const float GScore = SearchState.Get(CurrentId).GScore + GetCost(CurrentLink, neighbour);
+			if (GScore >= Neighbour.GScore) continue;
+
+			Neighbour.Parent = CurrentLink;
+			Neighbour.GScore = GScore;
+			Neighbour.FScore = GScore + Config.EstimateWeight * NearestHeuristicScore(neighbour, InTargetLinks);
+			OpenList.Push(neighbour, NeighbourId, Neighbour.FScore);
 		}
 
 		numIterations++;
 	}
 #if WITH_EDITOR
-	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), numIterations);
+	UE_LOG(LogSVONav, Display, TEXT("Nearest target search failed, iterations : %i"), numIterations);
 #endif
 	return 0;
 }
 
-void SVONavPathFinder::ApplyPathPruning(FSVONavPathSharedPtr* Path, const FSVONavPathFindingConfig InConfig) const
+float SVONavPathFinder::NearestHeuristicScore(const FSVONavLink& InLink, const TArray<FSVONavLink>& InTargetLinks)
 {
-	if (!World || InConfig.PathPruning == ESVONavPathPruning::None || Path->Get()->Points.Num() < 3) return;
-	FSVONavPath PrunedPath;
-	PrunedPath.Add(Path->Get()->Points[0]);
-	int32 CurrentPoint = 0;
-	float Radius = 0;
-	if (InConfig.PathPruning == ESVONavPathPruning::WithClearance)
+	// Minimum over the targets, so it stays admissible for whichever one ends up nearest
+	float Score = FLT_MAX;
+	for (const FSVONavLink& Target : InTargetLinks)
 	{
-		Radius = FMath::Max(50.f, NavComp->GetOwner()->GetComponentsBoundingBox(true).GetExtent().GetMax());
+		if (Target.IsValid()) Score = FMath::Min(Score, HeuristicScore(InLink, Target));
 	}
-	while (CurrentPoint < Path->Get()->Points.Num())
+	return Score;
+}
+
+float SVONavPathFinder::FindPathCost(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
+{
+	FSVONavPathFindingConfig CostConfig = GetAdmissibleConfig({InTargetLink});
+	SVONavPathFinder CostFinder(World, NavComp, SVOVolume, HieVolume, CostConfig);
+	return CostFinder.SearchPathCost(InStartLink, InTargetLink);
+}
+
+float SVONavPathFinder::SearchPathCost(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
+{
+	BeginAStar(InStartLink, InTargetLink);
+	if (StepAStar(0, 0.0, FVector::ZeroVector, FVector::ZeroVector, nullptr) != ESVONavPathQueryStatus::Succeeded)
 	{
-		for (int32 I = CurrentPoint; I < Path->Get()->Points.Num(); I++)
+		return -1.f;
+	}
+	return SearchState.Get(CurrentId).GScore;
+}
+
+FSVONavPathFindingConfig SVONavPathFinder::GetAdmissibleConfig(const TArray<FSVONavLink>& InTargetLinks) const
+{
+	// Steps cost at least their centre distance times the cheapest layer scale, cost fields only add to that.
+	// The straight line estimate is scaled by the target's layer instead, so the weight brings it down to the
+	// cheapest step. Unit costs have no bound per unit of distance and fall back to Dijkstra
+	FSVONavPathFindingConfig AdmissibleConfig = Config;
+	AdmissibleConfig.Heuristic = ESVONavHeuristic::Euclidean;
+	AdmissibleConfig.EstimateWeight = 0.f;
+	if (Config.UseUnitCost || !SVOVolume.OctreeValid()) return AdmissibleConfig;
+
+	const float NumLayers = SVOVolume.NumLayers;
+	const float MinStepScale = FMath::Min(1.f, 1.f - (NumLayers - 1.f) / NumLayers * Config.NodeSizePreference);
+	float MaxTargetScale = 0.f;
+	for (const FSVONavLink& Target : InTargetLinks)
+	{
+		if (!Target.IsValid()) continue;
+		MaxTargetScale = FMath::Max(MaxTargetScale,
+		                            1.f - static_cast<float>(Target.GetLayerIndex()) / NumLayers * Config.NodeSizePreference);
+	}
+	if (MinStepScale > 0.f && MaxTargetScale > 0.f) AdmissibleConfig.EstimateWeight = MinStepScale / MaxTargetScale;
+	return AdmissibleConfig;
+}
+
+void SVONavPathFinder::FindCostMatrix(const TArray<FSVONavLink>& InStartLinks,
+                                      const TArray<FSVONavLink>& InTargetLinks,
+                                      TArray<float>& OutCosts)
+{
+	const int32 NumTargets = InTargetLinks.Num();
+	OutCosts.Init(-1.f, InStartLinks.Num() * NumTargets);
+
+	// One search per link of the smaller side, backwards over reversed edges when that is the targets
+	const bool bBackward = NumTargets < InStartLinks.Num();
+	const TArray<FSVONavLink>& Sources = bBackward ? InTargetLinks : InStartLinks;
+	const TArray<FSVONavLink>& Sinks = bBackward ? InStartLinks : InTargetLinks;
+	const auto CostIndex = [bBackward, NumTargets](const int32 Source, const int32 Sink)
+	{
+		return bBackward ? Sink * NumTargets + Source : Source * NumTargets + Sink;
+	};
+
+	for (int32 S = 0; S < Sources.Num(); S++)
+	{
+		if (!Sources[S].IsValid()) continue;
+
+		// Repeated links share the first search
+		const int32 First = Sources.IndexOfByKey(Sources[S]);
+		if (First != S)
 		{
-			if (I >= Path->Get()->Points.Num() - 2)
-			{
-				PrunedPath.Add(Path->Get()->Points[Path->Get()->Points.Num() - 1]);
-				CurrentPoint = Path->Get()->Points.Num();
-				break;
-			}
-			FCollisionQueryParams CollisionQueryParams;
-			CollisionQueryParams.bTraceComplex = true;
-			CollisionQueryParams.TraceTag = "SVONavPathPrune";
-			FHitResult HitResult;
-			FVector Start = Path->Get()->Points[CurrentPoint].Location;
-			FVector End = Path->Get()->Points[I + 2].Location;
+			for (int32 K = 0; K < Sinks.Num(); K++) OutCosts[CostIndex(S, K)] = OutCosts[CostIndex(First, K)];
+			continue;
+		}
 
-			if (InConfig.PathPruning == ESVONavPathPruning::WithClearance)
+		TargetSet.Reset();
+		for (const FSVONavLink& Sink : Sinks)
+		{
+			if (Sink.IsValid()) TargetSet.Add(Sink);
+		}
+		if (TargetSet.Num() == 0) return;
+
+		// Dijkstra, done once every sink is settled
+		BeginSearch(SVOVolume, Sources[S], 0.f);
+		while (!OpenList.IsEmpty() && TargetSet.Num() > 0)
+		{
+			PopCurrent();
+			TargetSet.Remove(CurrentLink);
+
+			// The backward search walks the edges into the current link
+			TArray<FSVONavLink>& neighbours = Context.Neighbours;
+			if (bBackward) SVOVolume.GetSearchPredecessors(CurrentLink, neighbours);
+			else SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
+
+			for (const FSVONavLink& neighbour : neighbours)
+			{
+				if (!neighbour.IsValid()) continue;
+
+				const int32 NeighbourId = SVOVolume.GetNodeId(neighbour);
+				FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
+				if (Neighbour.bClosed) continue;
+
+				const float Cost = bBackward ? GetCost(neighbour, CurrentLink) : GetCost(CurrentLink, neighbour);
+				const float GScore = SearchState.Get(CurrentId).GScore + Cost;
+				if (GScore >= Neighbour.GScore) continue;
+
+				Neighbour.Parent = CurrentLink;
+				Neighbour.GScore = GScore;
+				Neighbour.FScore = GScore;
+				OpenList.Push(neighbour, NeighbourId, GScore);
+			}
+		}
+
+		for (int32 K = 0; K < Sinks.Num(); K++)
+		{
+			if (!Sinks[K].IsValid()) continue;
+			const FSVONavSearchNode* Node = SearchState.Find(SVOVolume.GetNodeId(Sinks[K]));
+			if (Node && Node->bClosed) OutCosts[CostIndex(S, K)] = Node->GScore;
+		}
+	}
+}
+
+int SVONavPathFinder::FindPathJumpPoint(const FSVONavLink& InStartLink,
+                                        const FSVONavLink& InTargetLink,
+                                        const FVector& InStartLocation,
+                                        const FVector& InTargetLocation,
+                                        FSVONavPathFindingConfig InConfig,
+                                        FSVONavPathSharedPtr* InPath)
+{
+	CurrentLink = FSVONavLink();
+	TargetLink = InTargetLink;
+	StartLink = InStartLink;
+	LeafCellCache.Reset();
+	JumpTargetCell = IsLeafSubNode(TargetLink) ? SVOVolume.GetLeafCellCoord(TargetLink) : FIntVector(-1);
+
+	BeginSearch(SVOVolume, InStartLink, HeuristicScore(InStartLink, TargetLink)); // Distance to target
+
+	int numIterations = 0;
+
+	while (!OpenList.IsEmpty())
+	{
+		PopCurrent();
+
+		if (CurrentLink == TargetLink)
+		{
+			// Keeps every jump point, including the target, with the layer of each link
+			BuildPathThrough(CurrentLink, nullptr, InStartLocation, InTargetLocation, InPath);
+			return numIterations;
+		}
+
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		neighbours.Reset();
+
+		// Jump through the leaf sub nodes, everywhere else the octree neighbours are expanded as usual. A free node
+		// above the leaves already stands for a whole empty cube, there is no run of cells to jump over
+		if (IsLeafSubNode(CurrentLink))
+		{
+			GetJumpSuccessors(neighbours);
+		}
+		else
+		{
+			SVOVolume.GetNeighbourLinks(CurrentLink, neighbours);
+		}
+
+		for (const FSVONavLink& neighbour : neighbours)
+		{
+			ProcessLink(neighbour);
+		}
+
+		numIterations++;
+	}
+#if WITH_EDITOR
+	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), numIterations);
+#endif
+	return 0;
+}
+
+void SVONavPathFinder::GetJumpSuccessors(TArray<FSVONavLink>& Successors)
+{
+	const FIntVector Cell = SVOVolume.GetLeafCellCoord(CurrentLink);
+
+	// A cell entered by a jump keeps the sub directions of the jump and its forced neighbours. The start, and cells
+	// entered from a larger node, jump every way
+	uint32 Directions = ((1u << 27) - 1) & ~(1u << CentreCell);
+	FSVONavLink ParentLink;
+	if (GetParentLink(SVOVolume, CurrentLink, ParentLink) && IsLeafSubNode(ParentLink))
+	{
+		const FIntVector Delta = Cell - SVOVolume.GetLeafCellCoord(ParentLink);
+		const FIntVector Direction(FMath::Sign(Delta.X), FMath::Sign(Delta.Y), FMath::Sign(Delta.Z));
+		Directions = GetForcedNeighbours(Cell, Direction);
+		for (int32 E = 0; E < 27; E++)
+		{
+			if (E != CentreCell && IsSubDirection(GetNeighbourhoodOffset(E), Direction)) Directions |= 1u << E;
+		}
+	}
+
+	for (int32 E = 0; E < 27; E++)
+	{
+		FSVONavLink JumpLink;
+		if ((Directions & 1u << E) != 0 && Jump(Cell, GetNeighbourhoodOffset(E), JumpLink)) Successors.Add(JumpLink);
+	}
+}
+
+bool SVONavPathFinder::Jump(FIntVector Cell, const FIntVector& Direction, FSVONavLink& OutLink)
+{
+	// Bit per moving axis, a diagonal move is made up of every non-empty proper subset of its axes
+	const int32 Mask = (Direction.X != 0 ? 1 : 0) | (Direction.Y != 0 ? 2 : 0) | (Direction.Z != 0 ? 4 : 0);
+	const auto SubDirection = [&Direction](const int32 SubMask)
+	{
+		return FIntVector(SubMask & 1 ? Direction.X : 0, SubMask & 2 ? Direction.Y : 0, SubMask & 4 ? Direction.Z : 0);
+	};
+
+	while (true)
+	{
+		// No corner cutting, every smaller step making up a diagonal move has to be free as well
+		for (int32 SubMask = 1; SubMask < Mask; SubMask++)
+		{
+			if ((SubMask & Mask) == SubMask && IsLeafCellBlocked(Cell + SubDirection(SubMask))) return false;
+		}
+
+		Cell += Direction;
+		const ESVONavLeafCell State = SVOVolume.GetLeafCell(Cell, LeafCellCache, &OutLink);
+		if (State == ESVONavLeafCell::Blocked) return false;
+
+		// Leaving the rasterized leaves, the covering node is expanded like any other octree node
+		if (State == ESVONavLeafCell::Open) return OutLink.IsValid();
+		if (Cell == JumpTargetCell || GetForcedNeighbours(Cell, Direction) != 0) return true;
+
+		// A diagonal stops where one of its sub directions reaches a jump point, the turn is a natural successor
+		for (int32 SubMask = 1; SubMask < Mask; SubMask++)
+		{
+			FSVONavLink SubLink;
+			if ((SubMask & Mask) == SubMask && Jump(Cell, SubDirection(SubMask), SubLink)) return true;
+		}
+	}
+}
+
+uint32 SVONavPathFinder::GetForcedNeighbours(const FIntVector& Cell, const FIntVector& Direction)
+{
+	// Only blocked cells stop a step. Alternatives have to stay on free leaf cells as well, open cells belong to
+	// larger nodes whose centres the search would route through instead
+	uint32 Blocked = 0;
+	uint32 Closed = 0;
+	for (int32 I = 0; I < 27; I++)
+	{
+		if (I == CentreCell) continue;
+		const ESVONavLeafCell State = SVOVolume.GetLeafCell(Cell + GetNeighbourhoodOffset(I), LeafCellCache);
+		if (State == ESVONavLeafCell::Blocked) Blocked |= 1u << I;
+		if (State != ESVONavLeafCell::Free) Closed |= 1u << I;
+	}
+	if (Closed == 0) return 0;
+
+	const FJumpPointTables& Tables = GetJumpPointTables();
+	const TArray<uint32>(&Alternatives)[27] = Tables.Alternatives[GetNeighbourhoodIndex(Direction)];
+	uint32 Forced = 0;
+	for (int32 E = 0; E < 27; E++)
+	{
+		if (E == CentreCell || (Blocked & Tables.StepMasks[E]) != 0 ||
+			IsSubDirection(GetNeighbourhoodOffset(E), Direction))
+		{
+			continue;
+		}
+		if (!Alternatives[E].ContainsByPredicate([Closed](const uint32 Mask) { return (Closed & Mask) == 0; }))
+		{
+			Forced |= 1u << E;
+		}
+	}
+	return Forced;
+}
+
+bool SVONavPathFinder::IsLeafSubNode(const FSVONavLink& Link) const
+{
+	return Link.GetLayerIndex() == 0 && SVOVolume.GetNode(Link).FirstChild.IsValid();
+}
+
+int SVONavPathFinder::FindPathBidirectional(const FSVONavLink& InStartLink,
+                                            const FSVONavLink& InTargetLink,
+                                            const FVector& InStartLocation,
+                                            const FVector& InTargetLocation,
+                                            FSVONavPathFindingConfig InConfig,
+                                            FSVONavPathSharedPtr* InPath)
+{
+	CurrentLink = FSVONavLink();
+	TargetLink = InTargetLink;
+	StartLink = InStartLink;
+
+	// Forward frontier grows from the start, the backward one from the target
+	BeginSearch(SVOVolume, InStartLink, HeuristicScore(InStartLink, TargetLink));
+
+	FSVONavSearchState& ReverseState = Context.ReverseSearchState;
+	ReverseState.Begin(SVOVolume.GetNodeIdCount());
+	Context.ReverseOpenList.Reset();
+	const int32 TargetId = SVOVolume.GetNodeId(TargetLink);
+	FSVONavSearchNode& Target = ReverseState.Get(TargetId);
+	Target.Parent = TargetLink;
+	Target.GScore = 0;
+	Target.FScore = HeuristicScore(TargetLink, StartLink);
+	Context.ReverseOpenList.Push(TargetLink, TargetId, Target.FScore);
+
+	float BestCost = StartLink == TargetLink ? 0.f : FLT_MAX;
+	FSVONavLink MeetingLink = StartLink == TargetLink ? StartLink : FSVONavLink();
+
+	int numIterations = 0;
+
+	// Nothing cheaper than the best meeting point can pass through a frontier whose best score is already higher
+	while (!OpenList.IsEmpty() && !Context.ReverseOpenList.IsEmpty() &&
+		OpenList.GetTopScore() < BestCost && Context.ReverseOpenList.GetTopScore() < BestCost)
+	{
+		// Grow the smaller frontier
+		ExpandBidirectional(OpenList.Num() <= Context.ReverseOpenList.Num(), BestCost, MeetingLink);
+		numIterations++;
+	}
+
+	if (MeetingLink.IsValid())
+	{
+		BuildPathThrough(MeetingLink, &Context.ReverseSearchState, InStartLocation, InTargetLocation, InPath);
+		return numIterations;
+	}
+#if WITH_EDITOR
+	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), numIterations);
+#endif
+	return 0;
+}
+
+void SVONavPathFinder::ExpandBidirectional(const bool bForward, float& BestCost, FSVONavLink& MeetingLink)
+{
+	FSVONavSearchState& State = bForward ? SearchState : Context.ReverseSearchState;
+	FSVONavOpenList& Frontier = bForward ? OpenList : Context.ReverseOpenList;
+	const FSVONavSearchState& OtherState = bForward ? Context.ReverseSearchState : SearchState;
+	const FSVONavLink& GoalLink = bForward ? TargetLink : StartLink;
+
+	const int32 ExpandId = Frontier.GetTopId();
+	const FSVONavLink ExpandLink = Frontier.Pop();
+	FSVONavSearchNode& ExpandNode = State.Get(ExpandId);
+	ExpandNode.bClosed = true;
+	const float ExpandGScore = ExpandNode.GScore;
+
+	// The backward frontier walks the edges into the expanded link, adjacency is not symmetric
+	TArray<FSVONavLink>& neighbours = Context.Neighbours;
+	if (bForward) SVOVolume.GetSearchNeighbours(ExpandLink, neighbours);
+	else SVOVolume.GetSearchPredecessors(ExpandLink, neighbours);
+
+	for (const FSVONavLink& neighbour : neighbours)
+	{
+		if (!neighbour.IsValid()) continue;
+
+		const int32 NeighbourId = SVOVolume.GetNodeId(neighbour);
+		FSVONavSearchNode& Neighbour = State.Get(NeighbourId);
+		if (Neighbour.bClosed) continue;
+
+		// Edges are always costed in the forward direction so both frontiers agree on the path cost
+		const float GScore = ExpandGScore + (bForward ? GetCost(ExpandLink, neighbour) : GetCost(neighbour, ExpandLink));
+		if (GScore >= Neighbour.GScore) continue;
+
+		Neighbour.Parent = ExpandLink;
+		Neighbour.GScore = GScore;
+		Neighbour.FScore = GScore + Config.EstimateWeight * HeuristicScore(neighbour, GoalLink);
+		Frontier.Push(neighbour, NeighbourId, Neighbour.FScore);
+
+		const FSVONavSearchNode* Other = OtherState.Find(NeighbourId);
+		if (Other && Other->GScore < FLT_MAX && GScore + Other->GScore < BestCost)
+		{
+			BestCost = GScore + Other->GScore;
+			MeetingLink = neighbour;
+		}
+	}
+}
+
+void SVONavPathFinder::BuildPathThrough(const FSVONavLink& EndLink, const FSVONavSearchState* ReverseState,
+                                        const FVector& InStartLocation, const FVector& InTargetLocation,
+                                        FSVONavPathSharedPtr* InPath)
+{
+	if (!InPath || !InPath->IsValid())
+		return;
+
+	TArray<FSVONavPathPoint>& Points = Context.PathPoints;
+	Points.Reset();
+
+	const auto AddPoint = [this, &Points](const FSVONavLink& Link)
+	{
+		FVector Location;
+		SVOVolume.GetLinkLocation(Link, Location);
+		// Same layer numbering as BuildPath, leaf sub nodes are layer 0
+		const int32 Layer = Link.GetLayerIndex() == 0
+			                    ? (SVOVolume.GetNode(Link).HasChildren() ? 0 : 1)
+			                    : Link.GetLayerIndex() + 1;
+		Points.Emplace(Location, Layer, Link.GetNodeIndex(), true);
+	};
+
+	// End link back to the start, then reversed
+	FSVONavLink Link = EndLink;
+	FSVONavLink NextLink;
+	AddPoint(Link);
+	while (GetParentLink(SearchState, SVOVolume, Link, NextLink))
+	{
+		Link = NextLink;
+		AddPoint(Link);
+	}
+	Algo::Reverse(Points);
+
+	// End link on to the target
+	Link = EndLink;
+	while (ReverseState && GetParentLink(*ReverseState, SVOVolume, Link, NextLink))
+	{
+		Link = NextLink;
+		AddPoint(Link);
+	}
+
+	// If start and end are in the same voxel, just use the start and target positions.
+	if (Points.Num() == 1)
+	{
+		const FSVONavPathPoint Point = Points[0];
+		Points.Add(Point);
+	}
+	Points[0].Location = InStartLocation;
+	Points.Last().Location = InTargetLocation;
+
+	InPath->Get()->GetPoints().Append(Points);
+}
+
+int SVONavPathFinder::FindPathAnytime(const FSVONavLink& InStartLink,
+                                      const FSVONavLink& InTargetLink,
+                                      const FVector& InStartLocation,
+                                      const FVector& InTargetLocation,
+                                      FSVONavPathFindingConfig InConfig,
+                                      FSVONavPathSharedPtr* InPath)
+{
+	BeginAnytime(InStartLink, InTargetLink);
+	if (StepAnytime(0, 0.0, InStartLocation, InTargetLocation, InPath) == ESVONavPathQueryStatus::Succeeded)
+	{
+		return FMath::Max(Expansions, 1);
+	}
+#if WITH_EDITOR
+	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), Expansions);
+#endif
+	return 0;
+}
+
+void SVONavPathFinder::BeginAnytime(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
+{
+	CurrentLink = FSVONavLink();
+	TargetLink = InTargetLink;
+	StartLink = InStartLink;
+	Expansions = 0;
+	AnytimeWeight = FMath::Max(1.f, Config.EstimateWeight);
+	AnytimePathCost = FLT_MAX;
+	AnytimeSeconds = 0.0;
+
+	BeginSearch(SVOVolume, InStartLink, AnytimeWeight * HeuristicScore(InStartLink, TargetLink));
+	Context.ClosedIds.Reset();
+	Context.InconsistentLinks.Reset();
+}
+
+ESVONavPathQueryStatus SVONavPathFinder::StepAnytime(const int32 MaxExpansions, const double EndTime,
+                                                     const FVector& InStartLocation,
+                                                     const FVector& InTargetLocation,
+                                                     FSVONavPathSharedPtr* InPath)
+{
+	const double StepStart = FPlatformTime::Seconds();
+	const int32 TargetId = SVOVolume.GetNodeId(TargetLink);
+	const float WeightStep = FMath::Max(KINDA_SMALL_NUMBER, Config.AnytimeWeightStep);
+
+	const int32 SliceLimit = MaxExpansions > 0 ? Expansions + MaxExpansions : MAX_int32;
+	const double SliceEnd = EndTime > 0.0 ? EndTime : TNumericLimits<double>::Max();
+	// The improvement budget spans every step, it only applies once there is a first path to fall back on
+	const int32 BudgetLimit = Config.MaxExpansions > 0 ? Config.MaxExpansions : MAX_int32;
+	const double BudgetEnd = Config.TimeBudget > 0.f
+		                         ? StepStart + Config.TimeBudget * 0.001 - AnytimeSeconds
+		                         : TNumericLimits<double>::Max();
+
+	ESVONavPathQueryStatus Status;
+	while (true)
+	{
+		const bool bBudgeted = AnytimePathCost < FLT_MAX;
+		const bool bPassComplete = ImprovePathAnytime(TargetId,
+		                                              bBudgeted ? FMath::Min(SliceLimit, BudgetLimit) : SliceLimit,
+		                                              bBudgeted ? FMath::Min(SliceEnd, BudgetEnd) : SliceEnd);
+		const FSVONavSearchNode* Target = SearchState.Find(TargetId);
+		if (!Target || Target->GScore == FLT_MAX)
+		{
+			Status = bPassComplete ? ESVONavPathQueryStatus::Failed : ESVONavPathQueryStatus::InProgress;
+			break;
+		}
+
+		// Write out any cheaper path, a complete pass is within the weight times the optimal cost
+		if (Target->GScore < AnytimePathCost)
+		{
+			AnytimePathCost = Target->GScore;
+			if (InPath)
+			{
+				InPath->Get()->Reset();
+				BuildPathThrough(TargetLink, nullptr, InStartLocation, InTargetLocation, InPath);
+			}
+#if WITH_EDITOR
+			UE_LOG(LogSVONav, Display, TEXT("Anytime path improved, weight : %f, cost : %f, iterations : %i"),
+			       AnytimeWeight, AnytimePathCost, Expansions);
+#endif
+		}
+		if (!bPassComplete)
+		{
+			// Either the improvement budget is spent or only this step's slice
+			const bool bBudgetSpent = Expansions >= BudgetLimit || FPlatformTime::Seconds() > BudgetEnd;
+			Status = bBudgetSpent ? ESVONavPathQueryStatus::Succeeded : ESVONavPathQueryStatus::Improving;
+			break;
+		}
+		if (AnytimeWeight <= 1.f)
+		{
+			Status = ESVONavPathQueryStatus::Succeeded;
+			break;
+		}
+
+		// Next pass reuses the search so far, the inconsistent links rejoin the open list and every key is re-weighted
+		AnytimeWeight = FMath::Max(1.f, AnytimeWeight - WeightStep);
+		for (const FSVONavLink& Link : Context.InconsistentLinks)
+		{
+			const int32 LinkId = SVOVolume.GetNodeId(Link);
+			OpenList.Push(Link, LinkId, SearchState.Get(LinkId).GScore);
+		}
+		Context.InconsistentLinks.Reset();
+		for (const int32 ClosedId : Context.ClosedIds) SearchState.Get(ClosedId).bClosed = false;
+		Context.ClosedIds.Reset();
+		OpenList.Rebuild([this](const FSVONavLink& Link, const int32 NodeId)
+		{
+			FSVONavSearchNode& Node = SearchState.Get(NodeId);
+			Node.FScore = Node.GScore + AnytimeWeight * HeuristicScore(Link, TargetLink);
+			return Node.FScore;
+		});
+	}
+
+	AnytimeSeconds += FPlatformTime::Seconds() - StepStart;
+	return Status;
+}
+
+bool SVONavPathFinder::ImprovePathAnytime(const int32 TargetId, const int32 ExpansionLimit, const double EndTime)
+{
+	while (!OpenList.IsEmpty())
+	{
+		// The current solution is already within the weight bound
+		const FSVONavSearchNode* Target = SearchState.Find(TargetId);
+		if (Target && Target->GScore <= OpenList.GetTopScore()) return true;
+
+		if (Expansions >= ExpansionLimit) return false;
+		// Timer is polled every 16 expansions, as in StepAStar
+		if ((Expansions & 15) == 0 && FPlatformTime::Seconds() > EndTime) return false;
+
+		PopCurrent();
+		Context.ClosedIds.Add(CurrentId);
+		const float CurrentGScore = SearchState.Get(CurrentId).GScore;
+
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
+
+		for (const FSVONavLink& neighbour : neighbours)
+		{
+			if (!neighbour.IsValid()) continue;
+
+			const int32 NeighbourId = SVOVolume.GetNodeId(neighbour);
+			FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
+			const float GScore = CurrentGScore + GetCost(CurrentLink, neighbour);
+			if (GScore >= Neighbour.GScore) continue;
+
+			Neighbour.Parent = CurrentLink;
+			Neighbour.GScore = GScore;
+			Neighbour.FScore = GScore + AnytimeWeight * HeuristicScore(neighbour, TargetLink);
+
+			// Links closed in this pass wait for the next one instead of being expanded twice
+			if (Neighbour.bClosed) Context.InconsistentLinks.Add(neighbour);
+			else OpenList.Push(neighbour, NeighbourId, Neighbour.FScore);
+		}
+
+		Expansions++;
+	}
+	return true;
+}
+
+int SVONavPathFinder::FindPathLazyTheta(const FSVONavLink& InStartLink,
+                                        const FSVONavLink& InTargetLink,
+                                        const FVector& InStartLocation,
+                                        const FVector& InTargetLocation,
+                                        FSVONavPathFindingConfig InConfig,
+                                        FSVONavPathSharedPtr* InPath)
+{
+	CurrentLink = FSVONavLink();
+	TargetLink = InTargetLink;
+	StartLink = InStartLink;
+
+	BeginSearch(SVOVolume, InStartLink, HeuristicScore(InStartLink, TargetLink)); // Distance to target
+
+	int numIterations = 0;
+
+	while (!OpenList.IsEmpty())
+	{
+		PopCurrent();
+		SetVertexLazyTheta();
+
+		if (CurrentLink == TargetLink)
+		{
+			BuildPathThrough(CurrentLink, nullptr, InStartLocation, InTargetLocation, InPath);
+			return numIterations;
+		}
+
+		TArray<FSVONavLink>& neighbours = Context.Neighbours;
+		SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
+
+		for (const FSVONavLink& neighbour : neighbours)
+		{
+			ProcessLinkLazyTheta(neighbour);
+		}
+
+		numIterations++;
+	}
+#if WITH_EDITOR
+	UE_LOG(LogSVONav, Display, TEXT("Pathfinding failed, iterations : %i"), numIterations);
+#endif
+	return 0;
+}
+
+void SVONavPathFinder::SetVertexLazyTheta()
+{
+	FSVONavSearchNode& Current = SearchState.Get(CurrentId);
+	if (Current.Parent == CurrentLink) return;
+
+	if (SVOVolume.IsLineOfSight(SVOVolume.GetLinkCentre(Current.Parent), SVOVolume.GetLinkCentre(CurrentLink))) return;
+
+	// Parent assumed visible when the link was queued is not, fall back to the best already closed neighbour
+	TArray<FSVONavLink>& neighbours = Context.Neighbours;
+	SVOVolume.GetSearchNeighbours(CurrentLink, neighbours);
+
+	float BestGScore = FLT_MAX;
+	FSVONavLink BestParent;
+	for (const FSVONavLink& neighbour : neighbours)
+	{
+		if (!neighbour.IsValid()) continue;
+		const FSVONavSearchNode* Neighbour = SearchState.Find(SVOVolume.GetNodeId(neighbour));
+		if (!Neighbour || !Neighbour->bClosed) continue;
+
+		const float GScore = Neighbour->GScore + GetCost(neighbour, CurrentLink);
+		if (GScore < BestGScore)
+		{
+			BestGScore = GScore;
+			BestParent = neighbour;
+		}
+	}
+
+	if (BestParent.IsValid())
+	{
+		Current.GScore = BestGScore;
+		Current.Parent = BestParent;
+	}
+}
+
+void SVONavPathFinder::ProcessLinkLazyTheta(const FSVONavLink& NeighbourLink)
+{
+	if (!NeighbourLink.IsValid()) return;
+
+	const int32 NeighbourId = SVOVolume.GetNodeId(NeighbourLink);
+	FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
+	if (Neighbour.bClosed) return;
+
+	// Optimistically connect to the current link's parent, visibility is only checked once the neighbour is expanded
+	const FSVONavSearchNode& Current = SearchState.Get(CurrentId);
+	const FSVONavLink& ParentLink = Current.Parent;
+	const float ParentGScore = ParentLink == CurrentLink
+		                           ? Current.GScore
+		                           : SearchState.Get(SVOVolume.GetNodeId(ParentLink)).GScore;
+
+	const float GScore = ParentGScore + GetCost(ParentLink, NeighbourLink);
+	if (GScore >= Neighbour.GScore) return;
+
+	Neighbour.Parent = ParentLink;
+	Neighbour.GScore = GScore;
+	Neighbour.FScore = GScore + Config.EstimateWeight * HeuristicScore(NeighbourLink, TargetLink);
+	OpenList.Push(NeighbourLink, NeighbourId, Neighbour.FScore);
+}
+
+void SVONavPathFinder::ApplyPathPruning(FSVONavPathSharedPtr* Path, const FSVONavPathFindingConfig InConfig) const
+{
+	if (!World || InConfig.PathPruning == ESVONavPathPruning::None || Path->Get()->Points.Num() < 3) return;
+	FSVONavPath& PrunedPath = Context.ScratchPath;
+	PrunedPath.Reset();
+	PrunedPath.Add(Path->Get()->Points[0]);
+	int32 CurrentPoint = 0;
+	float Radius = 0;
+	if (InConfig.PathPruning == ESVONavPathPruning::WithClearance)
+	{
+		Radius = FMath::Max(50.f, NavComp->GetOwner()->GetComponentsBoundingBox(true).GetExtent().GetMax());
+	}
+	while (CurrentPoint < Path->Get()->Points.Num())
+	{
+		for (int32 I = CurrentPoint; I < Path->Get()->Points.Num(); I++)
+		{
+			if (I >= Path->Get()->Points.Num() - 2)
+			{
+				PrunedPath.Add(Path->Get()->Points[Path->Get()->Points.Num() - 1]);
+				CurrentPoint = Path->Get()->Points.Num();
+				break;
+			}
+			FCollisionQueryParams CollisionQueryParams;
+			CollisionQueryParams.bTraceComplex = true;
+			CollisionQueryParams.TraceTag = "SVONavPathPrune";
+			FHitResult HitResult;
+			FVector Start = Path->Get()->Points[CurrentPoint].Location;
+			FVector End = Path->Get()->Points[I + 2].Location;
+
+			if (InConfig.PathPruning == ESVONavPathPruning::WithClearance)
 			{
 				World->SweepSingleByChannel(
 					HitResult,
@@ -693,7 +1670,7 @@ void SVONavPathFinder::ApplyPathPruning(FSVONavPathSharedPtr* Path, const FSVONa
 			}
 		}
 	}
-	*Path->Get() = PrunedPath;
+	Swap(Path->Get()->Points, PrunedPath.Points);
 }
 
 void SVONavPathFinder::ApplyPathLineOfSight(FSVONavPathSharedPtr* InPath, AActor* Target, float MinimumDistance) const
@@ -740,127 +1717,73 @@ void SVONavPathFinder::ApplyPathSmoothing(FSVONavPathSharedPtr* InPath, FSVONavP
 
 float SVONavPathFinder::HeuristicScore(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
 {
-	float Score;
-	FVector StartLocation, TargetLocation;
-
-	SVOVolume.GetLinkLocation(InStartLink, StartLocation);
-	SVOVolume.GetLinkLocation(InTargetLink, TargetLocation);
-
-	switch (Config.Heuristic)
-	{
-	case ESVONavHeuristic::Manhattan:
-		Score = FMath::Abs(TargetLocation.X - StartLocation.X) + FMath::Abs(TargetLocation.Y - StartLocation.Y) +
-			FMath::Abs(TargetLocation.Z - StartLocation.Z);
-		break;
-	case ESVONavHeuristic::Euclidean:
-	default:
-		Score = (StartLocation - TargetLocation).Size();
-		break;
-	}
-
-	Score *= (1.0f - (static_cast<float>(InTargetLink.GetLayerIndex()) / static_cast<float>(SVOVolume.NumLayers)) *
-		Config
-		.NodeSizePreference);
-	return Score;
+	return SVOVolume.GetHeuristicScore(InStartLink, InTargetLink, SVOTargetCache.Get(SVOVolume, InTargetLink), Config);
 }
 
 float SVONavPathFinder::HeuristicScoreHie(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
 {
-	float Score;
-	FVector StartLocation, TargetLocation;
-
-	HieVolume.GetLinkLocation(InStartLink, StartLocation);
-	HieVolume.GetLinkLocation(InTargetLink, TargetLocation);
-
-	switch (Config.Heuristic)
-	{
-	case ESVONavHeuristic::Manhattan:
-		Score = FMath::Abs(TargetLocation.X - StartLocation.X) + FMath::Abs(TargetLocation.Y - StartLocation.Y) +
-			FMath::Abs(TargetLocation.Z - StartLocation.Z);
-		break;
-	case ESVONavHeuristic::Euclidean:
-	default:
-		Score = (StartLocation - TargetLocation).Size();
-		break;
-	}
-
-	Score *= (1.0f - (static_cast<float>(InTargetLink.GetLayerIndex()) / static_cast<float>(HieVolume.NumLayers)) *
-		Config
-		.NodeSizePreference);
-	return Score;
+	return HieVolume.GetHeuristicScore(InStartLink, InTargetLink, HieTargetCache.Get(HieVolume, InTargetLink), Config);
 }
 
 float SVONavPathFinder::GetCost(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
 {
-	float Cost;
-
-	// Unit cost implementation
-	if (Config.UseUnitCost)
-	{
-		Cost = Config.UnitCost;
-	}
-	else
-	{
-		FVector StartPos(0.f), TargetPos(0.f);
-		SVOVolume.GetLinkLocation(InStartLink, StartPos);
-		SVOVolume.GetLinkLocation(InTargetLink, TargetPos);
-		Cost = (StartPos - TargetPos).Size();
-	}
-
-	Cost *= (1.0f - (static_cast<float>(InStartLink.GetLayerIndex()) / static_cast<float>(SVOVolume.NumLayers)) * Config
-		.NodeSizePreference);
-
-	return Cost;
+	return SVOVolume.GetTraversalCost(InStartLink, InTargetLink, Config);
 }
 
 float SVONavPathFinder::GetCostHie(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink)
 {
-	float Cost;
+	return HieVolume.GetTraversalCost(InStartLink, InTargetLink, Config);
+}
 
-	// Unit cost implementation
-	if (Config.UseUnitCost)
-	{
-		Cost = Config.UnitCost;
-	}
-	else
-	{
-		FVector StartPos(0.f), TargetPos(0.f);
-		HieVolume.GetLinkLocation(InStartLink, StartPos);
-		HieVolume.GetLinkLocation(InTargetLink, TargetPos);
-		Cost = (StartPos - TargetPos).Size();
-	}
+void SVONavPathFinder::BeginSearch(const ASVONavVolumeBase& Volume, const FSVONavLink& InStartLink,
+                                   const float StartScore)
+{
+	SearchState.Begin(Volume.GetNodeIdCount());
+	OpenList.Reset();
+
+	const int32 StartId = Volume.GetNodeId(InStartLink);
+	FSVONavSearchNode& Start = SearchState.Get(StartId);
+	Start.Parent = InStartLink;
+	Start.GScore = 0;
+	Start.FScore = StartScore;
+	OpenList.Push(InStartLink, StartId, StartScore);
+}
 
-	Cost *= (1.0f - (static_cast<float>(InStartLink.GetLayerIndex()) / static_cast<float>(HieVolume.NumLayers)) * Config
-		.NodeSizePreference);
+void SVONavPathFinder::PopCurrent()
+{
+	CurrentId = OpenList.GetTopId();
+	CurrentLink = OpenList.Pop();
+	SearchState.Get(CurrentId).bClosed = true;
+}
 
-	return Cost;
+bool SVONavPathFinder::GetParentLink(const FSVONavSearchState& State, const ASVONavVolumeBase& Volume,
+                                     const FSVONavLink& Link, FSVONavLink& OutParent)
+{
+	const FSVONavSearchNode* Node = State.Find(Volume.GetNodeId(Link));
+	if (!Node || !Node->Parent.IsValid() || Node->Parent == Link) return false;
+	OutParent = Node->Parent;
+	return true;
 }
 
 void SVONavPathFinder::ProcessLink(const FSVONavLink& NeighbourLink)
 {
 	if (NeighbourLink.IsValid())
 	{
-		if (ClosedSet.Contains(NeighbourLink))
+		const int32 NeighbourId = SVOVolume.GetNodeId(NeighbourLink);
+		FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
+		if (Neighbour.bClosed)
 			return;
 
-		if (!OpenSet.Contains(NeighbourLink))
-		{
-			OpenSet.Add(NeighbourLink);
-		}
-
-		float MaxGScore = FLT_MAX;
-		if (GScore.Contains(CurrentLink))
-			MaxGScore = GScore[CurrentLink] + GetCost(CurrentLink, NeighbourLink);
-		else
-			GScore.Add(CurrentLink, FLT_MAX);
-
-		if (MaxGScore >= (GScore.Contains(NeighbourLink) ? GScore[NeighbourLink] : FLT_MAX))
+		const float MaxGScore = SearchState.Get(CurrentId).GScore + GetCost(CurrentLink, NeighbourLink);
+		if (MaxGScore >= Neighbour.GScore)
 			return;
 
-		Parent.Add(NeighbourLink, CurrentLink);
-		GScore.Add(NeighbourLink, MaxGScore);
-		FScore.Add(NeighbourLink,
-		           GScore[NeighbourLink] + (Config.EstimateWeight * HeuristicScore(NeighbourLink, TargetLink)));
+		Neighbour.Parent = CurrentLink;
+		Neighbour.GScore = MaxGScore;
+		Neighbour.FScore = MaxGScore + (Config.EstimateWeight * HeuristicScore(NeighbourLink, TargetLink));
+
+		//queue the link, or decrease its key if it is already pending
+		OpenList.Push(NeighbourLink, NeighbourId, Neighbour.FScore);
 	}
 }
 
@@ -868,46 +1791,47 @@ void SVONavPathFinder::ProcessLinkHie(const FSVONavLink& NeighbourLink)
 {
 	if (NeighbourLink.IsValid())
 	{
-		//already explored
-		if (ClosedSet.Contains(NeighbourLink))
-			return;
+		ProcessLinkHie(NeighbourLink, GetCostHie(CurrentLink, NeighbourLink));
+	}
+}
 
-		//not yet added to pending set
-		if (!OpenSet.Contains(NeighbourLink))
-		{
-			OpenSet.Add(NeighbourLink);
-		}
+void SVONavPathFinder::ProcessLinkHie(const FSVONavLink& NeighbourLink, const float Cost)
+{
+	const int32 NeighbourId = HieVolume.GetNodeId(NeighbourLink);
+	FSVONavSearchNode& Neighbour = SearchState.Get(NeighbourId);
 
-		float MaxGScore = FLT_MAX;
-		if (GScore.Contains(CurrentLink))
-			MaxGScore = GScore[CurrentLink] + GetCostHie(CurrentLink, NeighbourLink);
-		else
-			GScore.Add(CurrentLink, FLT_MAX);
+	//already explored
+	if (Neighbour.bClosed)
+		return;
 
-		if (MaxGScore >= (GScore.Contains(NeighbourLink) ? GScore[NeighbourLink] : FLT_MAX))
-			return;
+	const float MaxGScore = SearchState.Get(CurrentId).GScore + Cost;
+	if (MaxGScore >= Neighbour.GScore)
+		return;
 
-		Parent.Add(NeighbourLink, CurrentLink);
-		GScore.Add(NeighbourLink, MaxGScore);
-		FScore.Add(NeighbourLink,
-		           GScore[NeighbourLink] + (Config.EstimateWeight * HeuristicScoreHie(NeighbourLink, TargetLink)));
-	}
+	Neighbour.Parent = CurrentLink;
+	Neighbour.GScore = MaxGScore;
+	Neighbour.FScore = MaxGScore + (Config.EstimateWeight * HeuristicScoreHie(NeighbourLink, TargetLink));
+
+	//not yet added to pending set, or pending with a worse score
+	OpenList.Push(NeighbourLink, NeighbourId, Neighbour.FScore);
 }
 
-void SVONavPathFinder::BuildPath(TMap<FSVONavLink, FSVONavLink>& InParent, FSVONavLink InCurrentLink,
+void SVONavPathFinder::BuildPath(FSVONavLink InCurrentLink,
                                  const FVector& InStartLocation, const FVector& InTargetLocation,
                                  FSVONavPathSharedPtr* InPath)
 {
 	FSVONavPathPoint Location;
 
-	TArray<FSVONavPathPoint> Points;
+	TArray<FSVONavPathPoint>& Points = Context.PathPoints;
+	Points.Reset();
 
 	if (!InPath || !InPath->IsValid())
 		return;
 
-	while (InParent.Contains(InCurrentLink) && !(InCurrentLink == InParent[InCurrentLink]))
+	FSVONavLink ParentLink;
+	while (GetParentLink(SVOVolume, InCurrentLink, ParentLink))
 	{
-		InCurrentLink = InParent[InCurrentLink];
+		InCurrentLink = ParentLink;
 		SVOVolume.GetLinkLocation(InCurrentLink, Location.Location);
 		Points.Add(Location);
 		const FSVONavNode& node = SVOVolume.GetNode(InCurrentLink);
@@ -947,20 +1871,22 @@ void SVONavPathFinder::BuildPath(TMap<FSVONavLink, FSVONavLink>& InParent, FSVON
 	}
 }
 
-void SVONavPathFinder::BuildPathHie(TMap<FSVONavLink, FSVONavLink>& InParent, FSVONavLink InCurrentLink,
+void SVONavPathFinder::BuildPathHie(FSVONavLink InCurrentLink,
                                     const FVector& InStartLocation, const FVector& InTargetLocation,
                                     FSVONavPathSharedPtr* InPath)
 {
 	FSVONavPathPoint Location;
 
-	TArray<FSVONavPathPoint> Points;
+	TArray<FSVONavPathPoint>& Points = Context.PathPoints;
+	Points.Reset();
 
 	if (!InPath || !InPath->IsValid())
 		return;
 
-	while (InParent.Contains(InCurrentLink) && !(InCurrentLink == InParent[InCurrentLink]))
+	FSVONavLink ParentLink;
+	while (GetParentLink(HieVolume, InCurrentLink, ParentLink))
 	{
-		InCurrentLink = InParent[InCurrentLink];
+		InCurrentLink = ParentLink;
 		HieVolume.GetLinkLocation(InCurrentLink, Location.Location);
 		Points.Add(Location);
 		const FSVONavNode& node = HieVolume.GetNode(InCurrentLink);
@@ -0,0 +1,60 @@
+﻿#include "SVONavPathQuery.h"
+
+#include "SVONavPathFinder.h"
+
+FSVONavPathQuery::FSVONavPathQuery(UWorld* InWorld,
+                                   USVONavComponent* InNavComp,
+                                   ASVONavVolume& InVolume,
+                                   ASVONavVolumeBase& InHieVolume,
+                                   const FSVONavPathFindingConfig& InConfig,
+                                   const FSVONavLink& InStartLink,
+                                   const FSVONavLink& InTargetLink,
+                                   const FVector& InStartLocation,
+                                   const FVector& InTargetLocation,
+                                   FSVONavPathSharedPtr* InPath)
+	: Config(InConfig),
+	  StartLocation(InStartLocation),
+	  TargetLocation(InTargetLocation),
+	  Path(InPath)
+{
+	PathFinder = MakeUnique<SVONavPathFinder>(InWorld, InNavComp, InVolume, InHieVolume, Config);
+	if (Config.Algorithm == ESVONavAlgorithm::AnytimeAStar) PathFinder->BeginAnytime(InStartLink, InTargetLink);
+	else PathFinder->BeginAStar(InStartLink, InTargetLink);
+}
+
+FSVONavPathQuery::~FSVONavPathQuery() = default;
+
+ESVONavPathQueryStatus FSVONavPathQuery::Step(const int32 MaxExpansions, const float MaxMicroseconds)
+{
+	if (IsComplete()) return Status;
+
+	const double EndTime = MaxMicroseconds > 0.f ? FPlatformTime::Seconds() + MaxMicroseconds * 0.000001 : 0.0;
+	if (Config.Algorithm == ESVONavAlgorithm::AnytimeAStar)
+	{
+		Status = PathFinder->StepAnytime(MaxExpansions, EndTime, StartLocation, TargetLocation, Path);
+		// Only a rewritten path needs post processing again
+		if (PathFinder->GetAnytimePathCost() >= PathCost) return Status;
+		PathCost = PathFinder->GetAnytimePathCost();
+	}
+	else
+	{
+		Status = PathFinder->StepAStar(MaxExpansions, EndTime, StartLocation, TargetLocation, Path);
+	}
+
+	if (HasPath())
+	{
+		PathFinder->ApplyPathPruning(Path, Config);
+		SVONavPathFinder::ApplyPathSmoothing(Path, Config);
+	}
+	return Status;
+}
+
+bool FSVONavPathQuery::SupportsAlgorithm(const ESVONavAlgorithm Algorithm)
+{
+	return Algorithm == ESVONavAlgorithm::GreedyAStar || Algorithm == ESVONavAlgorithm::AnytimeAStar;
+}
+
+int32 FSVONavPathQuery::GetExpansions() const
+{
+	return PathFinder->GetExpansions();
+}
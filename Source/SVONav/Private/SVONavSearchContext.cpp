@@ -0,0 +1,31 @@
+﻿#include "SVONavSearchContext.h"
+
+FSVONavSearchContextPool& FSVONavSearchContextPool::Get()
+{
+	static FSVONavSearchContextPool Pool;
+	return Pool;
+}
+
+FSVONavSearchContext& FSVONavSearchContextPool::Acquire()
+{
+	FScopeLock ScopeLock(&Lock);
+	if (FreeContexts.Num() > 0) return *FreeContexts.Pop(false);
+
+	return *Contexts.Add_GetRef(MakeUnique<FSVONavSearchContext>());
+}
+
+void FSVONavSearchContextPool::Release(FSVONavSearchContext& Context)
+{
+	FScopeLock ScopeLock(&Lock);
+	FreeContexts.Add(&Context);
+}
+
+void FSVONavSearchContextPool::Trim()
+{
+	FScopeLock ScopeLock(&Lock);
+	Contexts.RemoveAll([this](const TUniquePtr<FSVONavSearchContext>& Context)
+	{
+		return FreeContexts.Contains(Context.Get());
+	});
+	FreeContexts.Reset();
+}
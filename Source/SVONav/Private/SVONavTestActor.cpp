@@ -4,6 +4,8 @@
 #include "SVONavTestActor.h"
 
 #include "SVONavVolume.h"
+#include "SVONavPathFinder.h"
+#include "SVONav/SVONav.h"
 #include "Components/LineBatchComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/HUD.h"
@@ -82,6 +84,68 @@ bool ASVONavTestActor::FlushDebugLine()
 }
 
 #if WITH_EDITOR
+void ASVONavTestActor::BenchmarkPathfinding()
+{
+	if (!InitStartAndGoalActor()) return;
+	ASVONavTestActor* StartActor = IsPathStart ? this : SVONavTestActor;
+	ASVONavTestActor* TargetActor = IsPathStart ? SVONavTestActor : this;
+	USVONavComponent* NavComp = StartActor->NavComponent;
+	if (!NavComp->Volume && !NavComp->FindVolume()) return;
+	if (!NavComp->HieVolume && !NavComp->FindHierarchicalVolume()) return;
+
+	FSVONavPathFindingConfig Config = NavComp->GetPathFindingConfig();
+	// Every repeat has to search, a cached path would only time the cache lookup
+	Config.UsePathCache = false;
+	const bool bHierarchical = Config.Algorithm == ESVONavAlgorithm::HierarchicalAStar ||
+		Config.Algorithm == ESVONavAlgorithm::HierarchicalPortalAStar;
+	ASVONavVolumeBase* LinkVolume = bHierarchical
+		                                ? NavComp->HieVolume
+		                                : NavComp->Volume;
+
+	FSVONavLink StartLink;
+	FSVONavLink TargetLink;
+	const FVector StartLocation = StartActor->GetActorLocation();
+	const FVector TargetLocation = TargetActor->GetActorLocation();
+	if (!LinkVolume->GetLink(StartLocation, StartLink) || !LinkVolume->GetLink(TargetLocation, TargetLink))
+	{
+		UE_LOG(LogSVONav, Warning, TEXT("Benchmark: start or target link not found"));
+		return;
+	}
+
+	FSVONavPathSharedPtr Path = MakeShareable<FSVONavPath>(new FSVONavPath());
+	const auto RunBenchmark = [&](const ESVONavAlgorithm Algorithm)
+	{
+		Config.Algorithm = Algorithm;
+		int32 Expansions = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 I = 0; I < BenchmarkIterations; I++)
+		{
+			Path->Reset();
+			SVONavPathFinder PathFinder(GetWorld(), NavComp, *NavComp->Volume, *NavComp->HieVolume, Config);
+			Expansions = PathFinder.FindPath(StartLink, TargetLink, StartLocation, TargetLocation, Config, &Path);
+		}
+		const double AverageTime = (FPlatformTime::Seconds() - StartTime) * 1000.0 / BenchmarkIterations;
+
+		UE_LOG(LogSVONav, Display, TEXT("Benchmark %s: expansions %i, average time %f ms over %i queries"),
+		       *UEnum::GetValueAsString(Algorithm), Expansions, AverageTime, BenchmarkIterations);
+		return Expansions;
+	};
+
+	const ESVONavAlgorithm Algorithm = Config.Algorithm;
+	const int32 Expansions = RunBenchmark(Algorithm);
+
+	// Greedy A* on the same links is the baseline the other SVO volume searches are compared against
+	if (Algorithm != ESVONavAlgorithm::GreedyAStar && LinkVolume == NavComp->Volume)
+	{
+		const int32 BaselineExpansions = RunBenchmark(ESVONavAlgorithm::GreedyAStar);
+		if (BaselineExpansions > 0)
+		{
+			UE_LOG(LogSVONav, Display, TEXT("Benchmark %s: %f of the Greedy A* expansions"),
+			       *UEnum::GetValueAsString(Algorithm), static_cast<float>(Expansions) / BaselineExpansions);
+		}
+	}
+}
+
 void ASVONavTestActor::EditorApplyTranslation(const FVector& DeltaTranslation, bool bAltDown, bool bShiftDown,
                                               bool bCtrlDown)
 {
@@ -2,6 +2,7 @@
 
 #include "SVONavVolume.h"
 #include "Builders/CubeBuilder.h"
+#include "Async/ParallelFor.h"
 
 ASVONavVolume::ASVONavVolume(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -11,7 +12,6 @@ ASVONavVolume::ASVONavVolume(const FObjectInitializer& ObjectInitializer)
 void ASVONavVolume::InternalBuildOctree()
 {
 	InitRasterize();
-	Octree.Leaves.AddDefaulted(BlockedIndices[0].Num() * 8 * 0.25f);
 	
 	for (int32 I = 0; I < NumLayers; I++) RasterizeLayer(I);
 	
@@ -20,107 +20,71 @@ void ASVONavVolume::InternalBuildOctree()
 
 void ASVONavVolume::InitRasterize()
 {
-	BlockedIndices.Emplace();
-
-	for (int32 I = 0; I < GetLayerNodeCount(1); I++)
-	{
-		FVector Location;
-		GetNodeLocation(1, I, Location);
-		if (IsBlocked(Location, VoxelHalfSizes[1]))
-		{
-			BlockedIndices[0].Add(I);
-		}
-	}
-
-	for (int32 I = 0; I < VoxelExponent; I++)
-	{
-		BlockedIndices.Emplace();
-		for (uint_fast64_t& MortonCode : BlockedIndices[I])
-		{
-			BlockedIndices[I + 1].Add(MortonCode >> 3);
-		}
-	}
+	BuildBlockedIndices(1);
 }
 
 void ASVONavVolume::RasterizeLayer(uint8 LayerIndex)
 {
 	Octree.Layers.Emplace();
-	int32 LeafIndex = 0;
 	if (LayerIndex == 0)
 	{
-		Octree.Leaves.Reserve(BlockedIndices[0].Num() * 8);
-		Octree.Layers[0].Reserve(BlockedIndices[0].Num() * 8);
-		const int32 NumNodes = GetLayerNodeCount(0);
-		for (int32 I = 0; I < NumNodes; I++)
-		{			
-			if (BlockedIndices[0].Contains(I >> 3))
-			{
-				const int32 Index = GetLayer(0).Emplace();
-				FSVONavNode& NewNode = Octree.Layers[0][Index];
-				NewNode.MortonCode = I;
-				FVector NodeLocation;
-				GetNodeLocation(0, I, NodeLocation);
-				if (IsBlocked(NodeLocation, VoxelHalfSizes[0])) {
-					RasterizeLeaf(NodeLocation, LeafIndex);
-					NewNode.FirstChild.SetLayerIndex(0);
-					NewNode.FirstChild.SetNodeIndex(LeafIndex);
-					NewNode.FirstChild.SetSubNodeIndex(0);
-					LeafIndex++;
-				} else {
-					Octree.Leaves.AddDefaulted(1);
-					LeafIndex++;
-					NewNode.FirstChild.Invalidate();
-				}
-			}
+		TArray<mortoncode_t> NodeCodes;
+		GetSparseLayerCodes(0, BlockedIndices[0], NodeCodes);
+		GetLayer(0).SetNum(NodeCodes.Num());
+		for (int32 I = 0; I < NodeCodes.Num(); I++) GetLayer(0)[I].MortonCode = NodeCodes[I];
+
+		// One leaf per layer 0 node at the same index, the overlap tests run on the worker threads
+		TArray<bool> HasLeaf;
+		HasLeaf.SetNumZeroed(GetLayer(0).Num());
+		Octree.Leaves.SetNum(GetLayer(0).Num());
+		ParallelFor(GetLayer(0).Num(), [this, &HasLeaf](const int32 Index)
+		{
+			FVector NodeLocation;
+			GetNodeLocation(0, GetLayer(0)[Index].MortonCode, NodeLocation);
+			if (!IsBlocked(NodeLocation, VoxelHalfSizes[0])) return;
+			HasLeaf[Index] = true;
+			Octree.Leaves[Index].SubNodes = RasterizeLeafSubNodes(NodeLocation, VoxelHalfSizes[0]);
+		});
+
+		for (int32 Index = 0; Index < GetLayer(0).Num(); Index++)
+		{
+			FSVONavNode& NewNode = GetLayer(0)[Index];
+			if (HasLeaf[Index]) NewNode.FirstChild = FSVONavLink(0, Index, 0);
+			else NewNode.FirstChild.Invalidate();
 		}
 	} 
 	else if (GetLayer(LayerIndex - 1).Num() > 0)
 	{
-		Octree.Layers[LayerIndex].Reserve(BlockedIndices[LayerIndex].Num() * 8);
-		const int32 NumNodes = GetLayerNodeCount(LayerIndex);
-		for (int32 I = 0; I < NumNodes; I++)
+		TArray<mortoncode_t> NodeCodes;
+		GetSparseLayerCodes(LayerIndex, BlockedIndices[LayerIndex], NodeCodes);
+		Octree.Layers[LayerIndex].Reserve(NodeCodes.Num());
+		int32 Cursor = 0;
+		for (const mortoncode_t I : NodeCodes)
 		{
-			if (IsAnyMemberBlocked(LayerIndex, I))
+			// Add a node
+			const int32 Index = GetLayer(LayerIndex).Emplace();
+			FSVONavNode& NewNode = GetLayer(LayerIndex)[Index];
+			NewNode.MortonCode = I;
+			// The layer below holds all 8 children of each blocked code in code order, so a blocked node's first
+			// child sits at 8 times its rank
+			const int32 BlockedIndex = BlockedIndices[LayerIndex - 1].IndexOf(I, Cursor);
+			if (BlockedIndex != INDEX_NONE)
 			{
-				// Add a node
-				const int32 Index = GetLayer(LayerIndex).Emplace();
-				FSVONavNode& NewNode = GetLayer(LayerIndex)[Index];
-				NewNode.MortonCode = I;
-				int32 ChildIndex = 0;
-				if (GetNodeIndex(LayerIndex - 1, NewNode.MortonCode << 3, ChildIndex))
-				{
-					NewNode.FirstChild.SetLayerIndex(LayerIndex - 1);
-					NewNode.FirstChild.SetNodeIndex(ChildIndex);
-					for (int32 C = 0; C < 8; C++)
-					{
-						GetLayer(NewNode.FirstChild.GetLayerIndex())[NewNode.FirstChild.GetNodeIndex() + C].Parent.
-							SetLayerIndex(LayerIndex);
-						GetLayer(NewNode.FirstChild.GetLayerIndex())[NewNode.FirstChild.GetNodeIndex() + C].Parent.
-							SetNodeIndex(Index);
-					}
-				}
-				else
+				const int32 ChildIndex = BlockedIndex * 8;
+				NewNode.FirstChild.SetLayerIndex(LayerIndex - 1);
+				NewNode.FirstChild.SetNodeIndex(ChildIndex);
+				for (int32 C = 0; C < 8; C++)
 				{
-					NewNode.FirstChild.Invalidate();
+					GetLayer(NewNode.FirstChild.GetLayerIndex())[NewNode.FirstChild.GetNodeIndex() + C].Parent.
+						SetLayerIndex(LayerIndex);
+					GetLayer(NewNode.FirstChild.GetLayerIndex())[NewNode.FirstChild.GetNodeIndex() + C].Parent.
+						SetNodeIndex(Index);
 				}
 			}
-		}
-	}
-}
-
-void ASVONavVolume::RasterizeLeaf(FVector NodeLocation, int32 LeafIndex)
-{
-	const FVector Location = NodeLocation - VoxelHalfSizes[0];
-	const float VoxelScale = VoxelHalfSizes[0] * 0.5f;
-	for (int32 I = 0; I < 64; I++) {
-		uint_fast32_t X, Y, Z;
-		morton3D_64_decode(I, X, Y, Z);
-		const FVector VoxelLocation = Location + FVector(X * VoxelScale, Y * VoxelScale, Z * VoxelScale) + VoxelScale * 0.5f;
-		if (LeafIndex >= Octree.Leaves.Num() - 1) Octree.Leaves.AddDefaulted(1);
-
-		if (IsBlocked(VoxelLocation, VoxelScale * 0.5f))
-		{
-			Octree.Leaves[LeafIndex].SetSubNode(I);
+			else
+			{
+				NewNode.FirstChild.Invalidate();
+			}
 		}
 	}
 }
@@ -1,5 +1,12 @@
 ﻿#include "SVONavVolumeBase.h"
 #include "chrono"
+#include "EngineUtils.h"
+#include "Algo/BinarySearch.h"
+#include "SVONavCostModifierVolume.h"
+#include "SVONavGeometryVoxelizer.h"
+#include "SVONavOpenList.h"
+#include "SVONavSearchContext.h"
+#include "SVONavSearchState.h"
 #include "DrawDebugHelpers.h"
 #include "Components/LineBatchComponent.h"
 #include "SVONavUpdateOctreeTask.h"
@@ -31,6 +38,7 @@ void ASVONavVolumeBase::UpdateOctree()
 #endif
 
 	Octree = CachedOctree;
+	BuildSearchData();
 }
 
 bool ASVONavVolumeBase::BuildOctree()
@@ -42,7 +50,24 @@ bool ASVONavVolumeBase::BuildOctree()
 	const auto StartTime = high_resolution_clock::now();
 #endif
 
+	if (Rasterizer == ESVONavRasterizer::Geometry)
+	{
+		GeometryVoxelizer = MakeShared<FSVONavGeometryVoxelizer>();
+		GeometryVoxelizer->Gather(GetWorld(), GetBoundingBox().ExpandBy(Clearance), CollisionChannel);
+#if WITH_EDITOR
+		UE_LOG(LogTemp, Display, TEXT("Geometry Snapshot : %i triangles, %i solids"),
+		       GeometryVoxelizer->GetTriangleCount(), GeometryVoxelizer->GetSolidCount());
+#endif
+	}
+
 	InternalBuildOctree();
+	BlockedIndices.Empty();
+	GeometryVoxelizer.Reset();
+	BuildSearchData();
+	BakeCostField();
+	BuildLandmarks();
+	// Idle pooled contexts are sized for the old node ids
+	FSVONavSearchContextPool::Get().Trim();
 
 #if WITH_EDITOR
 	const float Duration = std::chrono::duration_cast<milliseconds>(high_resolution_clock::now() - StartTime).count() /
@@ -69,6 +94,10 @@ bool ASVONavVolumeBase::BuildOctree()
 	UE_LOG(LogTemp, Display, TEXT("Total Nodes : %i"), NumNodes);
 	UE_LOG(LogTemp, Display, TEXT("Total Leaves : %i"), Octree.Leaves.Num());
 	UE_LOG(LogTemp, Display, TEXT("Total Octree Bytes : %i"), NumBytes);
+	UE_LOG(LogTemp, Display, TEXT("Landmark Table Bytes : %i"), LandmarkTable.GetSize());
+	UE_LOG(LogTemp, Display, TEXT("Cost Field Bytes : %i"), CostField.Num());
+	UE_LOG(LogTemp, Display, TEXT("Predecessor Bytes : %i"),
+	       PredecessorOffsets.Num() * sizeof(int32) + Predecessors.Num() * sizeof(FSVONavLink));
 
 	DebugDrawOctree();
 #endif
@@ -79,6 +108,407 @@ void ASVONavVolumeBase::InternalBuildOctree()
 {
 }
 
+void ASVONavVolumeBase::BuildSearchData()
+{
+	BuildNodeIds();
+	BuildNodeCentres();
+	BuildPredecessors();
+}
+
+void ASVONavVolumeBase::BuildNodeIds()
+{
+	NodeIdOffsets.Reset(Octree.Layers.Num());
+	LeafNodeIds.Reset();
+	NodeIdCount = 0;
+	for (int32 I = 0; I < Octree.Layers.Num(); I++)
+	{
+		NodeIdOffsets.Add(NodeIdCount);
+		if (I > 0 || Octree.Leaves.Num() == 0)
+		{
+			NodeIdCount += Octree.Layers[I].Num();
+			continue;
+		}
+
+		// Prefix sum over layer 0, only the nodes with a leaf take an id per sub node
+		LeafNodeIds.SetNumUninitialized(Octree.Layers[0].Num() + 1);
+		for (int32 J = 0; J < Octree.Layers[0].Num(); J++)
+		{
+			LeafNodeIds[J] = NodeIdCount;
+			NodeIdCount += Octree.Layers[0][J].FirstChild.IsValid() ? 64 : 1;
+		}
+		LeafNodeIds.Last() = NodeIdCount;
+	}
+	OctreeRevision++;
+}
+
+void ASVONavVolumeBase::BuildNodeCentres()
+{
+	NodeCentres.SetNum(Octree.Layers.Num());
+	for (int32 I = 0; I < Octree.Layers.Num(); I++)
+	{
+		const TArray<FSVONavNode>& Layer = Octree.Layers[I];
+		FSVONavNodeCentres& Centres = NodeCentres[I];
+		Centres.X.SetNumUninitialized(Layer.Num());
+		Centres.Y.SetNumUninitialized(Layer.Num());
+		Centres.Z.SetNumUninitialized(Layer.Num());
+		Centres.HasLeaf.Reset();
+		for (int32 J = 0; J < Layer.Num(); J++)
+		{
+			FVector Location;
+			GetNodeLocation(I, Layer[J].MortonCode, Location);
+			Centres.X[J] = Location.X;
+			Centres.Y[J] = Location.Y;
+			Centres.Z[J] = Location.Z;
+		}
+	}
+
+	if (Octree.Layers.Num() == 0 || Octree.Leaves.Num() == 0) return;
+
+	FSVONavNodeCentres& LeafLayer = NodeCentres[0];
+	LeafLayer.HasLeaf.SetNumUninitialized(Octree.Layers[0].Num());
+	for (int32 J = 0; J < Octree.Layers[0].Num(); J++)
+	{
+		LeafLayer.HasLeaf[J] = Octree.Layers[0][J].FirstChild.IsValid();
+	}
+
+	// Same offsets GetLinkLocation applies
+	const float Scale = VoxelHalfSizes[0] * 2;
+	for (int32 SubNode = 0; SubNode < 64; SubNode++)
+	{
+		uint_fast32_t X, Y, Z;
+		morton3D_64_decode(SubNode, X, Y, Z);
+		SubNodeOffsets[SubNode] = FVector(X * Scale * 0.25f, Y * Scale * 0.25f, Z * Scale * 0.25f) - FVector(Scale * 0.375);
+	}
+}
+
+void ASVONavVolumeBase::BuildPredecessors()
+{
+	// Every link a search can stand on, subdivided nodes are never stepped onto
+	TArray<FSVONavLink> SearchLinks;
+	for (int32 I = 0; I < Octree.Layers.Num(); I++)
+	{
+		const TArray<FSVONavNode>& Layer = Octree.Layers[I];
+		for (int32 J = 0; J < Layer.Num(); J++)
+		{
+			if (!Layer[J].HasChildren())
+			{
+				SearchLinks.Emplace(I, J, 0);
+				continue;
+			}
+			if (I > 0 || !Octree.Leaves.IsValidIndex(Layer[J].FirstChild.NodeIndex)) continue;
+
+			const FSVONavLeafNode& Leaf = Octree.Leaves[Layer[J].FirstChild.NodeIndex];
+			for (int32 SubNode = 0; SubNode < 64; SubNode++)
+			{
+				if (!Leaf.GetSubNode(SubNode)) SearchLinks.Emplace(0, J, SubNode);
+			}
+		}
+	}
+
+	// Counting sort of the forward edges by the id they lead to
+	TArray<FSVONavLink> Neighbours;
+	PredecessorOffsets.Init(0, NodeIdCount + 1);
+	for (const FSVONavLink& Link : SearchLinks)
+	{
+		GetSearchNeighbours(Link, Neighbours);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			if (LinkNodeIsValid(Neighbour)) PredecessorOffsets[GetNodeId(Neighbour) + 1]++;
+		}
+	}
+	for (int32 Id = 0; Id < NodeIdCount; Id++) PredecessorOffsets[Id + 1] += PredecessorOffsets[Id];
+
+	TArray<int32> Cursors(PredecessorOffsets.GetData(), NodeIdCount);
+	Predecessors.SetNumUninitialized(PredecessorOffsets.Last());
+	for (const FSVONavLink& Link : SearchLinks)
+	{
+		GetSearchNeighbours(Link, Neighbours);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			if (LinkNodeIsValid(Neighbour)) Predecessors[Cursors[GetNodeId(Neighbour)]++] = Link;
+		}
+	}
+}
+
+void ASVONavVolumeBase::BuildLandmarks()
+{
+	LandmarkTable.Reset();
+	if (NumLandmarks <= 0 || NodeIdCount == 0) return;
+
+	// Any node that is not subdivided is part of the search graph, the first one seeds the landmark selection
+	FSVONavLink Seed;
+	for (int32 I = 0; I < Octree.Layers.Num() && !Seed.IsValid(); I++)
+	{
+		const int32 NodeIndex = Octree.Layers[I].IndexOfByPredicate([](const FSVONavNode& Node)
+		{
+			return !Node.HasChildren();
+		});
+		if (NodeIndex != INDEX_NONE) Seed = FSVONavLink(I, NodeIndex, 0);
+	}
+	if (!Seed.IsValid()) return;
+
+	// Keep as many of the lower layers as the budget allows, the top layer is always stored
+	const int64 BudgetCount = static_cast<int64>(LandmarkMemoryBudget * 1024.f * 1024.f) / (2 * sizeof(float)) /
+		NumLandmarks;
+	int32 StoredLayer = Octree.Layers.Num() - 1;
+	while (StoredLayer > 0 && NodeIdCount - NodeIdOffsets[StoredLayer - 1] <= BudgetCount) StoredLayer--;
+
+	LandmarkTable.NodeIdCount = NodeIdCount;
+	LandmarkTable.StoredLayer = StoredLayer;
+	LandmarkTable.FirstNodeId = NodeIdOffsets[StoredLayer];
+	const int32 StoredCount = LandmarkTable.GetStoredCount();
+	LandmarkTable.Distances.Reserve(NumLandmarks * StoredCount);
+	LandmarkTable.MaxDistances.Reserve(NumLandmarks * StoredCount);
+
+	// Farthest point selection, every landmark is the node furthest by path from the ones already picked
+	TArray<float> Distances;
+	TArray<float> MaxDistances;
+	TArray<float> MinDistances;
+	BuildLandmarkDistances(Seed, MinDistances);
+	for (int32 L = 0; L < NumLandmarks; L++)
+	{
+		int32 FarthestId = INDEX_NONE;
+		float FarthestDistance = 0.f;
+		for (int32 Id = 0; Id < NodeIdCount; Id++)
+		{
+			if (MinDistances[Id] == FLT_MAX || MinDistances[Id] <= FarthestDistance) continue;
+			FarthestDistance = MinDistances[Id];
+			FarthestId = Id;
+		}
+		if (FarthestId == INDEX_NONE) break;
+
+		const FSVONavLink Landmark = GetNodeLink(FarthestId);
+		BuildLandmarkDistances(Landmark, Distances);
+		for (int32 Id = 0; Id < NodeIdCount; Id++)
+		{
+			if (L == 0 || Distances[Id] < MinDistances[Id]) MinDistances[Id] = Distances[Id];
+		}
+
+		BuildLandmarkRanges(Distances, MaxDistances);
+		LandmarkTable.Landmarks.Add(Landmark);
+		LandmarkTable.Distances.Append(Distances.GetData() + LandmarkTable.FirstNodeId, StoredCount);
+		LandmarkTable.MaxDistances.Append(MaxDistances.GetData() + LandmarkTable.FirstNodeId, StoredCount);
+	}
+}
+
+FSVONavLink ASVONavVolumeBase::GetNodeLink(const int32 NodeId) const
+{
+	// Ids are laid out layer by layer, layer 0 with one id per sub node of the nodes that have a leaf
+	int32 Layer = NodeIdOffsets.Num() - 1;
+	while (NodeId < NodeIdOffsets[Layer]) Layer--;
+	if (Layer > 0 || LeafNodeIds.Num() == 0) return FSVONavLink(Layer, NodeId - NodeIdOffsets[Layer], 0);
+
+	const int32 NodeIndex = Algo::UpperBound(LeafNodeIds, NodeId) - 1;
+	return FSVONavLink(0, NodeIndex, NodeId - LeafNodeIds[NodeIndex]);
+}
+
+void ASVONavVolumeBase::UpdateCostField()
+{
+	if (!OctreeValid() || NodeIdCount == 0) return;
+
+	BakeCostField(&CostChangedLinks);
+	CostRevision++;
+
+#if WITH_EDITOR
+	UE_LOG(LogTemp, Display, TEXT("Cost field updated, %i links changed"), CostChangedLinks.Num());
+#endif
+}
+
+void ASVONavVolumeBase::BakeCostField(TArray<FSVONavLink>* OutChangedLinks)
+{
+	TArray<uint8> NewField;
+	UWorld* World = GetWorld();
+	if (World && NodeIdCount > 0)
+	{
+		const FBox VolumeBounds = GetBoundingBox();
+		for (TActorIterator<ASVONavCostModifierVolume> It(World); It; ++It)
+		{
+			ASVONavCostModifierVolume* Modifier = *It;
+			const FBox Bounds = Modifier->GetComponentsBoundingBox(true);
+			const int32 Value = FMath::Clamp(FMath::RoundToInt((Modifier->CostMultiplier - 1.f) / CostFieldStep), 0, 255);
+			if (Value == 0 || !Bounds.Intersect(VolumeBounds)) continue;
+
+			if (NewField.Num() == 0) NewField.SetNumZeroed(NodeIdCount);
+			for (int32 Id = 0; Id < NodeIdCount; Id++)
+			{
+				// Overlapping modifiers keep the highest multiplier
+				if (NewField[Id] >= Value) continue;
+				const FVector Centre = GetLinkCentre(GetNodeLink(Id));
+				if (Bounds.IsInside(Centre) && Modifier->EncompassesPoint(Centre)) NewField[Id] = Value;
+			}
+		}
+	}
+
+	if (OutChangedLinks)
+	{
+		OutChangedLinks->Reset();
+		const bool bHadField = CostField.Num() == NodeIdCount;
+		for (int32 Id = 0; Id < NodeIdCount; Id++)
+		{
+			const uint8 OldValue = bHadField ? CostField[Id] : 0;
+			const uint8 NewValue = NewField.Num() > 0 ? NewField[Id] : 0;
+			if (OldValue != NewValue) OutChangedLinks->Add(GetNodeLink(Id));
+		}
+	}
+
+	CostField = MoveTemp(NewField);
+	OnCostFieldBaked(OutChangedLinks);
+}
+
+void ASVONavVolumeBase::BuildLandmarkDistances(const FSVONavLink& Source, TArray<float>& OutDistances) const
+{
+	FSVONavSearchState State;
+	FSVONavOpenList OpenList(State);
+	TArray<FSVONavLink> Neighbours;
+	TArray<FSVONavLink> Predecessors;
+	State.Begin(NodeIdCount);
+	OutDistances.Init(FLT_MAX, NodeIdCount);
+
+	// Dijkstra over the same graph and edge lengths the searches use. Edges are walked both ways, so a distance never
+	// exceeds the path length in either direction and the bound holds however the searches face
+	const int32 SourceId = GetNodeId(Source);
+	State.Get(SourceId).GScore = 0.f;
+	OpenList.Push(Source, SourceId, 0.f);
+	while (!OpenList.IsEmpty())
+	{
+		const int32 NodeId = OpenList.GetTopId();
+		const FSVONavLink Link = OpenList.Pop();
+		FSVONavSearchNode& Node = State.Get(NodeId);
+		Node.bClosed = true;
+		OutDistances[NodeId] = Node.GScore;
+
+		const FVector Centre = GetLinkCentre(Link);
+		GetSearchNeighbours(Link, Neighbours);
+		GetSearchPredecessors(Link, Predecessors);
+		Neighbours.Append(Predecessors);
+		for (const FSVONavLink& Neighbour : Neighbours)
+		{
+			const int32 NeighbourId = GetNodeId(Neighbour);
+			FSVONavSearchNode& NeighbourNode = State.Get(NeighbourId);
+			if (NeighbourNode.bClosed) continue;
+
+			const float Distance = Node.GScore + (GetLinkCentre(Neighbour) - Centre).Size();
+			if (Distance >= NeighbourNode.GScore) continue;
+			NeighbourNode.GScore = Distance;
+			OpenList.Push(Neighbour, NeighbourId, Distance);
+		}
+	}
+}
+
+void ASVONavVolumeBase::BuildLandmarkRanges(TArray<float>& InOutDistances, TArray<float>& OutMaxDistances) const
+{
+	OutMaxDistances = InOutDistances;
+
+	// Nodes the Dijkstra stood on keep their own distance, hierarchical searches stand on subdivided nodes too
+	TBitArray<> Reached(false, NodeIdCount);
+	for (int32 Id = 0; Id < NodeIdCount; Id++) Reached[Id] = InOutDistances[Id] != FLT_MAX;
+	TBitArray<> Rolled(false, NodeIdCount);
+
+	// Bottom up, every other parent takes the nearest and farthest of the links below it. Blocked sub nodes are
+	// never searched and leave the range alone
+	for (int32 I = 0; I < Octree.Layers.Num() - 1; I++)
+	{
+		const TArray<FSVONavNode>& Layer = Octree.Layers[I];
+		for (int32 J = 0; J < Layer.Num(); J++)
+		{
+			if (!Layer[J].Parent.IsValid()) continue;
+			const int32 ParentId = GetNodeId(Layer[J].Parent);
+			if (Reached[ParentId]) continue;
+
+			const bool bLeaf = I == 0 && LeafNodeIds.Num() > 0 && Layer[J].FirstChild.IsValid();
+			const FSVONavLeafNode* Leaf = bLeaf ? &Octree.Leaves[Layer[J].FirstChild.NodeIndex] : nullptr;
+			const int32 FirstId = GetNodeId(FSVONavLink(I, J, 0));
+			const int32 EndId = bLeaf ? LeafNodeIds[J + 1] : FirstId + 1;
+			for (int32 Id = FirstId; Id < EndId; Id++)
+			{
+				if (Leaf && Leaf->GetSubNode(Id - FirstId)) continue;
+				if (!Rolled[ParentId])
+				{
+					Rolled[ParentId] = true;
+					InOutDistances[ParentId] = InOutDistances[Id];
+					OutMaxDistances[ParentId] = OutMaxDistances[Id];
+					continue;
+				}
+				InOutDistances[ParentId] = FMath::Min(InOutDistances[ParentId], InOutDistances[Id]);
+				OutMaxDistances[ParentId] = FMath::Max(OutMaxDistances[ParentId], OutMaxDistances[Id]);
+			}
+		}
+	}
+
+	// A range with an unreachable link in it bounds nothing
+	for (int32 Id = 0; Id < NodeIdCount; Id++)
+	{
+		if (OutMaxDistances[Id] == FLT_MAX) InOutDistances[Id] = FLT_MAX;
+		else if (InOutDistances[Id] == FLT_MAX) OutMaxDistances[Id] = FLT_MAX;
+	}
+}
+
+int32 ASVONavVolumeBase::GetLandmarkNodeId(FSVONavLink Link) const
+{
+	// Blocked sub nodes are left out of their ancestors' ranges
+	if (Link.GetLayerIndex() == 0 && LandmarkTable.StoredLayer > 0)
+	{
+		const FSVONavNode& Node = GetNode(Link);
+		if (Node.FirstChild.IsValid() && Octree.Leaves[Node.FirstChild.NodeIndex].GetSubNode(Link.SubNodeIndex))
+		{
+			return INDEX_NONE;
+		}
+	}
+
+	while (Link.GetLayerIndex() < LandmarkTable.StoredLayer)
+	{
+		Link = GetNode(Link).Parent;
+		if (!Link.IsValid()) return INDEX_NONE;
+	}
+	return GetNodeId(Link);
+}
+
+float ASVONavVolumeBase::GetLandmarkDistance(const FSVONavLink& StartLink, const FSVONavLink& TargetLink) const
+{
+	if (!LandmarkTable.IsValid(NodeIdCount)) return -1.f;
+
+	const int32 StartId = GetLandmarkNodeId(StartLink);
+	const int32 TargetId = GetLandmarkNodeId(TargetLink);
+	if (StartId == INDEX_NONE || TargetId == INDEX_NONE) return -1.f;
+
+	// Triangle inequality, |d(L, target) - d(L, start)| never exceeds d(start, target). Links below the stored layer
+	// only know their distance lies within their ancestor's range, so the bound takes the range ends furthest apart
+	float Bound = 0.f;
+	for (int32 L = 0; L < LandmarkTable.Landmarks.Num(); L++)
+	{
+		const float StartMin = LandmarkTable.Get(L, StartId);
+		const float TargetMin = LandmarkTable.Get(L, TargetId);
+		if (StartMin == FLT_MAX || TargetMin == FLT_MAX) continue;
+		const float StartMax = LandmarkTable.GetMax(L, StartId);
+		const float TargetMax = LandmarkTable.GetMax(L, TargetId);
+		Bound = FMath::Max(Bound, FMath::Max(TargetMin - StartMax, StartMin - TargetMax));
+	}
+	return Bound;
+}
+
+void ASVONavVolumeBase::GetSearchNeighbours(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const
+{
+	NeighbourLinks.Reset();
+	if (Link.GetLayerIndex() == 0 && GetNode(Link).FirstChild.IsValid())
+	{
+		GetNeighbourLeaves(Link, NeighbourLinks);
+	}
+	else
+	{
+		GetNeighbourLinks(Link, NeighbourLinks);
+	}
+}
+
+void ASVONavVolumeBase::GetSearchPredecessors(const FSVONavLink& Link, TArray<FSVONavLink>& PredecessorLinks) const
+{
+	PredecessorLinks.Reset();
+	if (PredecessorOffsets.Num() != NodeIdCount + 1) return;
+
+	const int32 NodeId = GetNodeId(Link);
+	const int32 First = PredecessorOffsets[NodeId];
+	PredecessorLinks.Append(Predecessors.GetData() + First, PredecessorOffsets[NodeId + 1] - First);
+}
+
 void ASVONavVolumeBase::GetMortonVoxel(const FVector& Location, int32 LayerIndex, FIntVector& MortonLocation) const
 {
 	const FVector LocationLocal = Location - (VolumeOrigin - VolumeExtent);
@@ -153,6 +583,18 @@ void ASVONavVolumeBase::BeginPlay()
 	SetActorTickInterval(TickInterval);
 }
 
+void ASVONavVolumeBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	FSVONavSearchContextPool::Get().Trim();
+}
+
+void ASVONavVolumeBase::Destroyed()
+{
+	Super::Destroyed();
+	FSVONavSearchContextPool::Get().Trim();
+}
+
 void ASVONavVolumeBase::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
@@ -250,6 +692,11 @@ void ASVONavVolumeBase::Initialise()
 {
 	Octree.Reset();
 	BlockedIndices.Empty();
+	NodeIdOffsets.Empty();
+	LeafNodeIds.Empty();
+	NodeIdCount = 0;
+	PredecessorOffsets.Empty();
+	Predecessors.Empty();
 	NumBytes = 0;
 
 #if WITH_EDITOR
@@ -418,6 +865,119 @@ void ASVONavVolumeBase::GetNeighbourLeaves(const FSVONavLink& Link, TArray<FSVON
 	}
 }
 
+FIntVector ASVONavVolumeBase::GetLeafCellCoord(const FSVONavLink& Link) const
+{
+	uint_fast32_t X, Y, Z, SubX, SubY, SubZ;
+	morton3D_64_decode(GetNode(Link).MortonCode, X, Y, Z);
+	morton3D_64_decode(Link.SubNodeIndex, SubX, SubY, SubZ);
+	return FIntVector(X * 4 + SubX, Y * 4 + SubY, Z * 4 + SubZ);
+}
+
+ESVONavLeafCell ASVONavVolumeBase::GetLeafCell(const FIntVector& Cell, FSVONavLeafCellCache& Cache,
+                                               FSVONavLink* Link) const
+{
+	const int32 MaxCoordinate = GetSegmentNodeCount(0) * 4;
+	if (Octree.Layers.Num() == 0 ||
+		Cell.X < 0 || Cell.X >= MaxCoordinate ||
+		Cell.Y < 0 || Cell.Y >= MaxCoordinate ||
+		Cell.Z < 0 || Cell.Z >= MaxCoordinate)
+	{
+		return ESVONavLeafCell::Blocked;
+	}
+
+	const mortoncode_t NodeCode = morton3D_64_encode(Cell.X >> 2, Cell.Y >> 2, Cell.Z >> 2);
+	const int32 Slot = NodeCode & 7;
+	if (Cache.Codes[Slot] != NodeCode)
+	{
+		int32 Index;
+		Cache.Codes[Slot] = NodeCode;
+		Cache.Indices[Slot] = GetNodeIndex(0, NodeCode, Index) ? Index : INDEX_NONE;
+	}
+	const int32 NodeIndex = Cache.Indices[Slot];
+
+	if (NodeIndex == INDEX_NONE)
+	{
+		// Not subdivided down to layer 0, find the free node covering the cell
+		if (Link)
+		{
+			Link->Invalidate();
+			for (int32 LayerIndex = 1; LayerIndex < Octree.Layers.Num(); LayerIndex++)
+			{
+				const int32 Shift = 2 + LayerIndex;
+				int32 Index;
+				if (!GetNodeIndex(LayerIndex, morton3D_64_encode(Cell.X >> Shift, Cell.Y >> Shift, Cell.Z >> Shift),
+				                  Index))
+					continue;
+				if (!Octree.Layers[LayerIndex][Index].HasChildren()) *Link = FSVONavLink(LayerIndex, Index, 0);
+				break;
+			}
+		}
+		return ESVONavLeafCell::Open;
+	}
+
+	const FSVONavNode& Node = Octree.Layers[0][NodeIndex];
+	if (!Node.FirstChild.IsValid())
+	{
+		if (Link) *Link = FSVONavLink(0, NodeIndex, 0);
+		return ESVONavLeafCell::Open;
+	}
+
+	const mortoncode_t SubCode = morton3D_64_encode(Cell.X & 3, Cell.Y & 3, Cell.Z & 3);
+	if (Octree.Leaves[Node.FirstChild.NodeIndex].GetSubNode(SubCode)) return ESVONavLeafCell::Blocked;
+	if (Link) *Link = FSVONavLink(0, NodeIndex, SubCode);
+	return ESVONavLeafCell::Free;
+}
+
+bool ASVONavVolumeBase::IsLineOfSight(const FVector& Start, const FVector& End) const
+{
+	if (Octree.Layers.Num() == 0) return true;
+	const FVector StartToEnd = End - Start;
+
+	// Only leaf sub nodes are ever occluded, nodes without children are free space
+	TArray<FSVONavLink, TInlineAllocator<64>> Links;
+	const int32 TopLayer = Octree.Layers.Num() - 1;
+	for (int32 I = 0; I < Octree.Layers[TopLayer].Num(); I++) Links.Emplace(TopLayer, I, 0);
+
+	while (Links.Num() > 0)
+	{
+		const FSVONavLink Link = Links.Pop(false);
+		const FSVONavNode& Node = GetNode(Link);
+		if (!Node.HasChildren()) continue;
+
+		FVector NodeLocation;
+		GetNodeLocation(Link.LayerIndex, Node.MortonCode, NodeLocation);
+		const FBox NodeBox = FBox::BuildAABB(NodeLocation, FVector(VoxelHalfSizes[Link.LayerIndex]));
+		if (!FMath::LineBoxIntersection(NodeBox, Start, End, StartToEnd)) continue;
+
+		if (Link.LayerIndex > 0)
+		{
+			for (int32 C = 0; C < 8; C++)
+			{
+				Links.Emplace(Node.FirstChild.LayerIndex, Node.FirstChild.NodeIndex + C, 0);
+			}
+			continue;
+		}
+
+		// Test the occluded sub nodes, shrunk slightly so a segment grazing a face between free cells stays visible
+		const FSVONavLeafNode& Leaf = Octree.Leaves[Node.FirstChild.NodeIndex];
+		const float SubNodeSize = VoxelHalfSizes[0] * 0.5f;
+		const FVector SubNodeExtent(SubNodeSize * 0.49f);
+		const FVector Corner = NodeLocation - FVector(VoxelHalfSizes[0]) + FVector(SubNodeSize * 0.5f);
+		uint_fast64_t SubNodes = Leaf.SubNodes;
+		while (SubNodes)
+		{
+			const uint_fast64_t SubCode = FMath::CountTrailingZeros64(SubNodes);
+			SubNodes &= SubNodes - 1;
+			uint_fast32_t X, Y, Z;
+			morton3D_64_decode(SubCode, X, Y, Z);
+			const FVector SubNodeLocation = Corner + FVector(X, Y, Z) * SubNodeSize;
+			if (FMath::LineBoxIntersection(FBox::BuildAABB(SubNodeLocation, SubNodeExtent), Start, End, StartToEnd))
+				return false;
+		}
+	}
+	return true;
+}
+
 const FSVONavLeafNode& ASVONavVolumeBase::GetLeafNode(nodeindex_t aIndex) const
 {
 	return Octree.Leaves[aIndex];
@@ -520,36 +1080,130 @@ const FSVONavNode& ASVONavVolumeBase::GetNode(const FSVONavPathPoint& Point) con
 	return Octree.Layers[Point.Layer][Point.Index];
 }
 
-int32 ASVONavVolumeBase::GetLayerNodeCount(layerindex_t LayerIndex) const
+int64 ASVONavVolumeBase::GetLayerNodeCount(layerindex_t LayerIndex) const
 {
-	return FMath::Pow(8, VoxelExponent - LayerIndex);
+	return 1LL << 3 * (VoxelExponent - LayerIndex);
 }
 
-bool ASVONavVolumeBase::IsAnyMemberBlocked(layerindex_t LayerIndex, mortoncode_t Code) const
+const FSVONavNode& ASVONavVolumeBase::GetNode(const FSVONavLink& Link) const
 {
-	const mortoncode_t parentCode = Code >> 3;
+	return Octree.Layers[Link.LayerIndex][Link.NodeIndex];
+}
 
-	if (LayerIndex == BlockedIndices.Num())
+
+void ASVONavVolumeBase::RasterizeBlockedCodes(const layerindex_t LayerIndex, TArray<mortoncode_t>& OutCodes) const
+{
+	// A free node's test box contains its children's, so only the children of blocked nodes are tested on the way
+	// down and the work follows the blocked surface rather than the volume
+	TArray<mortoncode_t> Codes = {0};
+	for (int32 Layer = VoxelExponent; Layer > LayerIndex; Layer--)
 	{
-		return true;
+		FilterBlockedCodes(Layer, Codes, OutCodes);
+		Codes.Reset(OutCodes.Num() * 8);
+		for (const mortoncode_t Code : OutCodes)
+		{
+			for (mortoncode_t Child = 0; Child < 8; Child++) Codes.Add(Code << 3 | Child);
+		}
 	}
-	// The parent of this code is blocked
-	if (BlockedIndices[LayerIndex].Contains(parentCode))
+	FilterBlockedCodes(LayerIndex, Codes, OutCodes);
+}
+
+void ASVONavVolumeBase::BuildBlockedIndices(const layerindex_t LayerIndex)
+{
+	TArray<mortoncode_t> BlockedCodes;
+	RasterizeBlockedCodes(LayerIndex, BlockedCodes);
+
+	BlockedIndices.SetNum(VoxelExponent + 1);
+	BlockedIndices[0].Set(MoveTemp(BlockedCodes), GetLayerNodeCount(LayerIndex));
+	for (int32 I = 0; I < VoxelExponent; I++) BlockedIndices[I + 1].SetParentsOf(BlockedIndices[I]);
+}
+
+void ASVONavVolumeBase::FilterBlockedCodes(const layerindex_t LayerIndex, const TArray<mortoncode_t>& Codes,
+                                           TArray<mortoncode_t>& OutCodes) const
+{
+	OutCodes.Reset();
+	if (Codes.Num() == 0) return;
+
+	// Each chunk is a contiguous run of sorted codes, a compact block of space. Chunks are appended in order, so the
+	// codes come out sorted and identical whatever the core count
+	const int32 NumChunks = FMath::Min(Codes.Num(), 512);
+	const int32 ChunkSize = FMath::DivideAndRoundUp(Codes.Num(), NumChunks);
+	TArray<TArray<mortoncode_t>> ChunkCodes;
+	ChunkCodes.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&](const int32 Chunk)
 	{
-		return true;
-	}
+		const int32 Last = FMath::Min(Chunk * ChunkSize + ChunkSize, Codes.Num());
+		for (int32 I = Chunk * ChunkSize; I < Last; I++)
+		{
+			FVector Location;
+			GetNodeLocation(LayerIndex, Codes[I], Location);
+			if (IsBlocked(Location, VoxelHalfSizes[LayerIndex])) ChunkCodes[Chunk].Add(Codes[I]);
+		}
+	});
 
-	return false;
+	int32 NumCodes = 0;
+	for (const TArray<mortoncode_t>& Chunk : ChunkCodes) NumCodes += Chunk.Num();
+	OutCodes.Reset(NumCodes);
+	for (const TArray<mortoncode_t>& Chunk : ChunkCodes) OutCodes.Append(Chunk);
 }
 
-const FSVONavNode& ASVONavVolumeBase::GetNode(const FSVONavLink& Link) const
+void ASVONavVolumeBase::GetSparseLayerCodes(const layerindex_t LayerIndex, const FSVONavOccupancyLayer& BlockedParents,
+                                            TArray<mortoncode_t>& OutCodes) const
 {
-	return Octree.Layers[Link.LayerIndex][Link.NodeIndex];
+	// The root's parent code is 0 as well, only one of its children exists
+	const int64 NumNodes = GetLayerNodeCount(LayerIndex);
+	OutCodes.Reset(BlockedParents.Num() * 8);
+	for (const mortoncode_t Parent : BlockedParents.Codes)
+	{
+		for (mortoncode_t Child = 0; Child < 8; Child++)
+		{
+			const mortoncode_t Code = Parent << 3 | Child;
+			if (Code < static_cast<mortoncode_t>(NumNodes)) OutCodes.Add(Code);
+		}
+	}
 }
 
+uint_fast64_t ASVONavVolumeBase::RasterizeLeafSubNodes(const FVector& NodeLocation, const float NodeHalfSize) const
+{
+	const FVector Location = NodeLocation - NodeHalfSize;
+	const float OctantScale = NodeHalfSize;
+	const float VoxelScale = NodeHalfSize * 0.5f;
+	uint_fast64_t SubNodes = 0;
+
+	if (IsSolid(NodeLocation, NodeHalfSize)) return MAX_uint64;
+
+	// The top three bits of a sub node code pick its 2x2x2 octant. Free octants are skipped and solid ones filled
+	// whole, only the partially blocked ones are tested sub node by sub node. Physics cannot prove an octant solid,
+	// IsSolid is free there and blocked octants are always tested sub node by sub node
+	for (int32 Octant = 0; Octant < 8; Octant++)
+	{
+		uint_fast32_t X, Y, Z;
+		morton3D_64_decode(Octant, X, Y, Z);
+		const FVector OctantLocation = Location + FVector(X * OctantScale, Y * OctantScale, Z * OctantScale) +
+			OctantScale * 0.5f;
+		if (!IsBlocked(OctantLocation, OctantScale * 0.5f)) continue;
+		if (IsSolid(OctantLocation, OctantScale * 0.5f))
+		{
+			SubNodes |= 0xFFULL << Octant * 8;
+			continue;
+		}
+
+		for (int32 I = Octant * 8; I < Octant * 8 + 8; I++)
+		{
+			morton3D_64_decode(I, X, Y, Z);
+			const FVector VoxelLocation = Location + FVector(X * VoxelScale, Y * VoxelScale, Z * VoxelScale) +
+				VoxelScale * 0.5f;
+			if (IsBlocked(VoxelLocation, VoxelScale * 0.5f)) SubNodes |= 1ULL << I;
+		}
+	}
+	return SubNodes;
+}
 
 bool ASVONavVolumeBase::IsBlocked(const FVector& Location, float Size) const
 {
+	if (GeometryVoxelizer) return GeometryVoxelizer->IsBlocked(Location, FVector(Size + Clearance));
+
 	return GetWorld()->OverlapBlockingTestByChannel(
 		Location,
 		FQuat::Identity,
@@ -559,6 +1213,12 @@ bool ASVONavVolumeBase::IsBlocked(const FVector& Location, float Size) const
 	);
 }
 
+bool ASVONavVolumeBase::IsSolid(const FVector& Location, float Size) const
+{
+	// Overlap queries cannot tell a box inside geometry from one touching it, only the geometry snapshot can
+	return GeometryVoxelizer && GeometryVoxelizer->IsContained(Location, FVector(Size));
+}
+
 bool ASVONavVolumeBase::IsBlocked(const FVector& Location, float Size, TArray<FOverlapResult>& OverlapResults) const
 {
 	return GetWorld()->OverlapMultiByChannel(
@@ -573,11 +1233,26 @@ bool ASVONavVolumeBase::IsBlocked(const FVector& Location, float Size, TArray<FO
 
 void ASVONavVolumeBase::Serialize(FArchive& Ar)
 {
+	Ar.UsingCustomVersion(FSVONavCustomVersion::GUID);
 	Super::Serialize(Ar);
 	Ar << Octree;
 	Ar << VoxelHalfSizes;
 	Ar << VolumeExtent;
+	if (Ar.CustomVer(FSVONavCustomVersion::GUID) >= FSVONavCustomVersion::LandmarkTables) Ar << LandmarkTable;
+	if (Ar.CustomVer(FSVONavCustomVersion::GUID) >= FSVONavCustomVersion::CostFields) Ar << CostField;
+	// Tables saved before compact node ids are indexed by the old ids, they come back with the next build
+	if (Ar.IsLoading() && Ar.CustomVer(FSVONavCustomVersion::GUID) < FSVONavCustomVersion::CompactNodeIds)
+	{
+		LandmarkTable.Reset();
+		CostField.Empty();
+	}
+	// Landmark tables saved without ranges only hold the nearest distance, which is not a bound below the stored layer
+	if (Ar.IsLoading() && Ar.CustomVer(FSVONavCustomVersion::GUID) < FSVONavCustomVersion::LandmarkRanges)
+	{
+		LandmarkTable.Reset();
+	}
 	NumBytes = Octree.GetSize();
+	if (Ar.IsLoading()) BuildSearchData();
 }
 
 #if WITH_EDITOR
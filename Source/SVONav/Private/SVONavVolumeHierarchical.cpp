@@ -1,7 +1,8 @@
-// Fill out your copyright notice in the Description page of Project Settings.
+﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 
 #include "SVONavVolumeHierarchical.h"
+#include "Async/ParallelFor.h"
 
 ASVONavVolumeHierarchical::ASVONavVolumeHierarchical(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -50,84 +51,238 @@ void ASVONavVolumeHierarchical::Serialize(FArchive& Ar)
 	Ar << DuplicatedMortonMatrix;
 }
 
-void ASVONavVolumeHierarchical::GetNeighbourLinks(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const
+void ASVONavVolumeHierarchical::BuildSearchData()
 {
-	if (!LinkNodeIsValid(Link)) return;
-	const FSVONavNode& Node = GetNode(Link);
-	NeighbourLinks = Node.NeighbourSet;
+	Super::BuildSearchData();
+	BuildConnectedComponents();
+	BuildRegionTables();
 }
 
-void ASVONavVolumeHierarchical::InitRasterize()
+bool ASVONavVolumeHierarchical::IsReachable(const FSVONavLink& StartLink, const FSVONavLink& TargetLink) const
 {
-	BlockedIndices.Emplace();
+	if (!LinkNodeIsValid(StartLink) || !LinkNodeIsValid(TargetLink)) return false;
+	return GetComponentId(StartLink) == GetComponentId(TargetLink);
+}
 
-	for (int32 I = 0; I < GetLayerNodeCount(3); I++)
+void ASVONavVolumeHierarchical::BuildConnectedComponents()
+{
+	// Union-find over neighbour links, with every node also joined to its parent since a parent stands for
+	// one connected group of its children
+	ComponentIds.SetNumUninitialized(GetNodeIdCount());
+	for (int32 I = 0; I < ComponentIds.Num(); I++) ComponentIds[I] = I;
+
+	const auto FindRoot = [this](int32 Id)
 	{
-		FVector Location;
-		GetNodeLocation(3, I, Location);
-		if (IsBlocked(Location, VoxelHalfSizes[3]))
+		while (ComponentIds[Id] != Id)
 		{
-			BlockedIndices[0].Add(I);
+			ComponentIds[Id] = ComponentIds[ComponentIds[Id]];
+			Id = ComponentIds[Id];
 		}
-	}
+		return Id;
+	};
+	const auto Union = [this, &FindRoot](const int32 A, const int32 B)
+	{
+		const int32 RootA = FindRoot(A);
+		const int32 RootB = FindRoot(B);
+		if (RootA != RootB) ComponentIds[FMath::Max(RootA, RootB)] = FMath::Min(RootA, RootB);
+	};
 
-	for (int32 I = 0; I < VoxelExponent; I++)
+	for (int32 LayerIndex = 0; LayerIndex < Octree.Layers.Num(); LayerIndex++)
 	{
-		BlockedIndices.Emplace();
-		for (uint_fast64_t& MortonCode : BlockedIndices[I])
+		const TArray<FSVONavNode>& Layer = Octree.Layers[LayerIndex];
+		for (int32 I = 0; I < Layer.Num(); I++)
 		{
-			BlockedIndices[I + 1].Add(MortonCode >> 3);
+			const FSVONavNode& Node = Layer[I];
+			const int32 NodeId = GetNodeId(FSVONavLink(LayerIndex, I, 0));
+			for (const FSVONavLink& Neighbour : Node.NeighbourSet)
+			{
+				if (LinkNodeIsValid(Neighbour)) Union(NodeId, GetNodeId(Neighbour));
+			}
+			if (LinkNodeIsValid(Node.Parent)) Union(NodeId, GetNodeId(Node.Parent));
 		}
 	}
+
+	// Flatten so lookups are a single load
+	for (int32 I = 0; I < ComponentIds.Num(); I++) ComponentIds[I] = FindRoot(I);
 }
 
-void ASVONavVolumeHierarchical::RasterizeLayer0()
+void ASVONavVolumeHierarchical::BuildRegionTables()
 {
-	Octree.Layers.Emplace();
-	int32 LeafIndex = 0;
+	RegionTables.Reset();
+	RegionTableIndices.Init(INDEX_NONE, GetNodeIdCount());
+	RegionMemberIndices.Init(INDEX_NONE, GetNodeIdCount());
 
-	const int32 NumNodes = GetLayerNodeCount(2);
+	for (int32 LayerIndex = 1; LayerIndex < Octree.Layers.Num(); LayerIndex++)
+	{
+		const TArray<FSVONavNode>& Layer = Octree.Layers[LayerIndex];
+		for (int32 I = 0; I < Layer.Num(); I++)
+		{
+			const FSVONavNode& Node = Layer[I];
+			if (!Node.HasChildren() || Node.Children.Num() == 0) continue;
+
+			RegionTableIndices[GetNodeId(FSVONavLink(LayerIndex, I, 0))] = RegionTables.Num();
+			FSVONavRegionTable& Table = RegionTables.Emplace_GetRef();
+			Table.Members = Node.Children;
+			for (int32 M = 0; M < Table.Members.Num(); M++) RegionMemberIndices[GetNodeId(Table.Members[M])] = M;
+			BuildRegionRoutes(Table);
+		}
+	}
+}
+
+void ASVONavVolumeHierarchical::BuildRegionRoutes(FSVONavRegionTable& Table) const
+{
+	const int32 Num = Table.Members.Num();
+	Table.IsPortal.Init(false, Num);
+	Table.Costs.Init(FLT_MAX, Num * Num);
+	Table.NextHop.Init(INDEX_NONE, Num * Num);
 
-	for (int32 I = 0; I < NumNodes; I++)
+	// Direct links between siblings, anything else makes the member a portal
+	for (int32 From = 0; From < Num; From++)
 	{
-		if (BlockedIndices[0].Contains(I >> 3))
+		Table.Costs[From * Num + From] = 0.f;
+		Table.NextHop[From * Num + From] = From;
+
+		const FSVONavLink& FromLink = Table.Members[From];
+		for (const FSVONavLink& Neighbour : GetNode(FromLink).NeighbourSet)
 		{
-			FVector NodeLocation;
-			GetNodeLocation(2, I, NodeLocation);
-			if (IsBlocked(NodeLocation, VoxelHalfSizes[2]))
+			if (!LinkNodeIsValid(Neighbour)) continue;
+
+			const int32 To = Table.Members.IndexOfByKey(Neighbour);
+			if (To == INDEX_NONE)
 			{
-				const FVector Location = NodeLocation - VoxelHalfSizes[2];
-				const float VoxelScale = VoxelHalfSizes[2] * 0.5f;
-				for (int32 V = 0; V < 64; V++)
-				{
-					uint_fast32_t X, Y, Z;
-					morton3D_64_decode(V, X, Y, Z);
-					const FVector VoxelLocation = Location + FVector(X * VoxelScale, Y * VoxelScale, Z * VoxelScale) +
-						VoxelScale *
-						0.5f;
+				Table.IsPortal[From] = true;
+				continue;
+			}
 
-					if (!IsBlocked(VoxelLocation, VoxelScale * 0.5f))
-					{
-						//create first layer of hierarchical octree
-						int32 Index = Octree.Layers[0].Emplace();
-						FSVONavNode& NewNode = Octree.Layers[0][Index];
-
-						FIntVector Voxel;
-						GetMortonVoxel(VoxelLocation, 0, Voxel);
-						const uint_fast64_t MortonCode = morton3D_64_encode(Voxel.X, Voxel.Y, Voxel.Z);
-						NewNode.MortonCode = MortonCode;
-					}
-				}
-				LeafIndex++;
+			// Scaled like GetTraversalCost, so routes avoid the same costly space the searches do
+			const float Cost = (GetLinkCentre(Neighbour) - GetLinkCentre(FromLink)).Size() * GetCostScale(Neighbour);
+			if (Cost < Table.Costs[From * Num + To])
+			{
+				Table.Costs[From * Num + To] = Cost;
+				Table.NextHop[From * Num + To] = To;
 			}
-			else
+		}
+	}
+
+	// Floyd-Warshall, a region only holds the connected children of one parent
+	for (int32 Via = 0; Via < Num; Via++)
+	{
+		for (int32 From = 0; From < Num; From++)
+		{
+			const float FromVia = Table.Costs[From * Num + Via];
+			if (FromVia == FLT_MAX) continue;
+			for (int32 To = 0; To < Num; To++)
 			{
-				LeafIndex++;
+				const float ViaTo = Table.Costs[Via * Num + To];
+				if (ViaTo == FLT_MAX || FromVia + ViaTo >= Table.Costs[From * Num + To]) continue;
+				Table.Costs[From * Num + To] = FromVia + ViaTo;
+				Table.NextHop[From * Num + To] = Table.NextHop[From * Num + Via];
 			}
 		}
 	}
 }
 
+void ASVONavVolumeHierarchical::OnCostFieldBaked(const TArray<FSVONavLink>* ChangedLinks)
+{
+	if (!ChangedLinks)
+	{
+		for (FSVONavRegionTable& Table : RegionTables) BuildRegionRoutes(Table);
+		return;
+	}
+
+	// Only the regions holding a changed link have different routes
+	TSet<int32> ChangedTables;
+	for (const FSVONavLink& Link : *ChangedLinks)
+	{
+		const FSVONavLink& ParentLink = GetNode(Link).Parent;
+		if (!LinkNodeIsValid(ParentLink)) continue;
+		const int32 TableIndex = RegionTableIndices[GetNodeId(ParentLink)];
+		if (TableIndex != INDEX_NONE) ChangedTables.Add(TableIndex);
+	}
+	for (const int32 TableIndex : ChangedTables) BuildRegionRoutes(RegionTables[TableIndex]);
+}
+
+void ASVONavVolumeHierarchical::GetRegionRoute(const FSVONavLink& From, const FSVONavLink& To,
+                                               TArray<FSVONavLink>& Route) const
+{
+	Route.Reset();
+	const FSVONavLink& ParentLink = GetNode(From).Parent;
+	if (ParentLink != GetNode(To).Parent) return;
+
+	const FSVONavRegionTable* Table = GetRegionTable(ParentLink);
+	int32 Current = GetRegionMemberIndex(From);
+	const int32 Target = GetRegionMemberIndex(To);
+	if (!Table || Current == INDEX_NONE || Target == INDEX_NONE) return;
+
+	while (true)
+	{
+		Current = Table->GetNextHop(Current, Target);
+		if (Current == INDEX_NONE || Current == Target) break;
+		Route.Add(Table->Members[Current]);
+	}
+}
+
+void ASVONavVolumeHierarchical::GetNeighbourLinks(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const
+{
+	if (!LinkNodeIsValid(Link)) return;
+	const FSVONavNode& Node = GetNode(Link);
+	NeighbourLinks.Append(Node.NeighbourSet);
+}
+
+void ASVONavVolumeHierarchical::InitRasterize()
+{
+	BuildBlockedIndices(3);
+}
+
+void ASVONavVolumeHierarchical::RasterizeLayer0()
+{
+	Octree.Layers.Emplace();
+
+	TArray<mortoncode_t> NodeCodes;
+	GetSparseLayerCodes(2, BlockedIndices[0], NodeCodes);
+
+	// Overlap tests run on the worker threads, nodes are created afterwards in code order so the layer is sorted
+	TArray<bool> IsNodeBlocked;
+	TArray<uint_fast64_t> SubNodes;
+	IsNodeBlocked.SetNumZeroed(NodeCodes.Num());
+	SubNodes.SetNumZeroed(NodeCodes.Num());
+	ParallelFor(NodeCodes.Num(), [&](const int32 I)
+	{
+		FVector NodeLocation;
+		GetNodeLocation(2, NodeCodes[I], NodeLocation);
+		if (!IsBlocked(NodeLocation, VoxelHalfSizes[2])) return;
+		IsNodeBlocked[I] = true;
+		SubNodes[I] = RasterizeLeafSubNodes(NodeLocation, VoxelHalfSizes[2]);
+	});
+
+	for (int32 I = 0; I < NodeCodes.Num(); I++)
+	{
+		if (!IsNodeBlocked[I]) continue;
+
+		FVector NodeLocation;
+		GetNodeLocation(2, NodeCodes[I], NodeLocation);
+		const FVector Location = NodeLocation - VoxelHalfSizes[2];
+		const float VoxelScale = VoxelHalfSizes[2] * 0.5f;
+		for (int32 V = 0; V < 64; V++)
+		{
+			if (SubNodes[I] & 1ULL << V) continue;
+
+			uint_fast32_t X, Y, Z;
+			morton3D_64_decode(V, X, Y, Z);
+			const FVector VoxelLocation = Location + FVector(X * VoxelScale, Y * VoxelScale, Z * VoxelScale) +
+				VoxelScale * 0.5f;
+
+			//create first layer of hierarchical octree
+			const int32 Index = Octree.Layers[0].Emplace();
+			FSVONavNode& NewNode = Octree.Layers[0][Index];
+
+			FIntVector Voxel;
+			GetMortonVoxel(VoxelLocation, 0, Voxel);
+			NewNode.MortonCode = morton3D_64_encode(Voxel.X, Voxel.Y, Voxel.Z);
+		}
+	}
+}
+
 bool ASVONavVolumeHierarchical::GetLinkLocation(const FSVONavLink& Link, FVector& Location) const
 {
 	const FSVONavNode& Node = GetNode(Link);
@@ -157,17 +312,10 @@ void ASVONavVolumeHierarchical::RasterizeLayer1()
 void ASVONavVolumeHierarchical::RasterizeSparseLayer(layerindex_t LayerIndex)
 {
 	Octree.Layers.Emplace();
-	Octree.Layers[LayerIndex].Reserve(BlockedIndices[LayerIndex - 2].Num() * 8);
-	const int32 NumNodes = GetLayerNodeCount(LayerIndex);
-	for (int32 I = 0; I < NumNodes; I++)
-	{
-		if (BlockedIndices[LayerIndex - 2].Contains(I >> 3))
-		{
-			const int32 Index = Octree.Layers[LayerIndex].Emplace();
-			FSVONavNode& NewNode = Octree.Layers[LayerIndex][Index];
-			NewNode.MortonCode = I;
-		}
-	}
+	TArray<mortoncode_t> NodeCodes;
+	GetSparseLayerCodes(LayerIndex, BlockedIndices[LayerIndex - 2], NodeCodes);
+	Octree.Layers[LayerIndex].SetNum(NodeCodes.Num());
+	for (int32 I = 0; I < NodeCodes.Num(); I++) Octree.Layers[LayerIndex][I].MortonCode = NodeCodes[I];
 }
 
 void ASVONavVolumeHierarchical::BuildLayer0Link(layerindex_t LayerIndex)
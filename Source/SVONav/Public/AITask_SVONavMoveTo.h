@@ -117,6 +117,8 @@ protected:
 
 	void RequestPathSynchronous();
 	void RequestPathAsync();
+	// Continuous tracking replans through the nav component's incremental planner when it opts in
+	void RequestPathIncremental();
 
 	void RequestMove();
 
@@ -3,6 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "SVONavFlowField.h"
+#include "SVONavIncrementalPlanner.h"
+#include "SVONavPathBatch.h"
+#include "SVONavPathQuery.h"
 #include "SVONavType.h"
 #include "SVONavVolumeBase.h"
 #include "Components/ActorComponent.h"
@@ -61,6 +65,43 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding")
 	float UnitCost = 5.0f;
 
+	// Anytime A*: how much the heuristic weight drops between improved paths
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|Anytime", meta=(ClampMin = "0.01"))
+	float AnytimeWeightStep = 1.0f;
+
+	// Anytime A*: maximum node expansions spent improving a path, 0 for unlimited
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|Anytime", meta=(ClampMin = "0"))
+	int32 MaxExpansions = 0;
+
+	// Anytime A*: maximum milliseconds spent improving a path, 0 for unlimited
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|Anytime", meta=(ClampMin = "0"))
+	float TimeBudget = 2.0f;
+
+	// Replan continuous goal tracking moves through the incremental planner instead of the configured algorithm
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding")
+	bool bUseIncrementalReplanning = false;
+
+	// Serve repeated requests between the same octree nodes from the shared path cache
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding")
+	bool bUsePathCache = true;
+
+	// Run FindPathAsync as budgeted slices on the game thread instead of as a background task. Algorithms that cannot be
+	// sliced still run as a background task
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|TimeSlicing")
+	bool bTimeSlicedPathfinding = false;
+
+	// Node expansions a time sliced query may spend per tick, 0 for unlimited
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|TimeSlicing", meta=(ClampMin = "0"))
+	int32 SliceExpansionBudget = 256;
+
+	// Microseconds a time sliced query may spend per tick, 0 for unlimited. Leave at 0 for frame deterministic results
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Pathfinding|TimeSlicing", meta=(ClampMin = "0"))
+	float SliceTimeBudget = 0.f;
+
+	// How far from the goal a shared flow field reaches, 0 covers the whole volume
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|FlowField", meta=(ClampMin = "0"))
+	float FlowFieldRadius = 20000.f;
+
 #if WITH_EDITOR
 	// Whether to debug draw the pathfinding paths
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Debugging")
@@ -86,18 +127,43 @@ public:
 	                   /* const FFindPathTaskCompleteDynamicDelegate OnComplete,*/
 	                   ESVONavPathFindingCallResult& Result);
 
+	/* Solves all requests on the worker threads grouped by target region, poll the batch and apply its results together */
+	FSVONavPathBatchRef FindPathBatchAsync(const TArray<FSVONavPathRequest>& Requests);
+
 	bool FindPathImmediate(const FVector& StartLocation, const FVector& TargetLocation,
 	                       const bool bCheckLineOfSight, FSVONavPathSharedPtr* NavPath,
 	                       ESVONavPathFindingCallResult& Result);
 
+	/* Replans through the component's persistent incremental planner, repairing the previous search tree */
+	bool FindPathIncremental(const FVector& StartLocation, const FVector& TargetLocation,
+	                         FSVONavPathSharedPtr* NavPath, ESVONavPathFindingCallResult& Result);
+
+	/* Paths to whichever target is nearest by travel distance with a single search, OutTargetIndex indexes TargetLocations */
+	bool FindPathToNearestImmediate(const FVector& StartLocation, const TArray<FVector>& TargetLocations,
+	                                FSVONavPathSharedPtr* NavPath, int32& OutTargetIndex,
+	                                ESVONavPathFindingCallResult& Result);
+
+	/* Travel cost between two locations without building, pruning or smoothing a path */
+	bool FindPathCostImmediate(const FVector& StartLocation, const FVector& TargetLocation, float& OutCost,
+	                           ESVONavPathFindingCallResult& Result);
+
+	/* Travel costs from every start to every target, row major by start, negative where unreachable */
+	bool FindCostMatrixImmediate(const TArray<FVector>& StartLocations, const TArray<FVector>& TargetLocations,
+	                             TArray<float>& OutCosts, ESVONavPathFindingCallResult& Result);
+
 	bool FindPathHierarchicalImmediate(const FVector& StartLocation, const FVector& TargetLocation,
 	                                   const bool bCheckLineOfSight, FSVONavPathSharedPtr* NavPath,
 	                                   ESVONavPathFindingCallResult& Result);
 
+	/* Steers along the flow field shared by every agent heading to Goal instead of requesting a path */
+	UFUNCTION(BlueprintCallable, Category = "SVONav|Pathfinding")
+	bool GetFlowFieldDirection(AActor* Goal, FVector& OutDirection, float& OutDistance);
+
 	UFUNCTION(BlueprintCallable, Category = "SVONav|Pathfinding")
 	bool DoesPathExist(const FVector StartLocation, const FVector TargetLocation);
 
 	FSVONavPathSharedPtr& GetPath() { return SVONavPath; }
+	FSVONavPathFindingConfig GetPathFindingConfig() const;
 	virtual FVector GetPawnPosition() const;
 
 	virtual bool DoesPathExistInternal(const FSVONavLink& StartLink,
@@ -110,6 +176,17 @@ public:
 	                                   TArray<FSVONavLink>& TargetLinksLevels);
 
 protected:
+	// Search tree kept between FindPathIncremental calls, created on first use
+	TUniquePtr<FSVONavIncrementalPlanner> IncrementalPlanner;
+
+	// Time sliced query stepped from TickComponent, a new request completes it as failed and takes its place
+	TUniquePtr<FSVONavPathQuery> PathQuery;
+	FThreadSafeBool* PathQueryCompleteFlag = nullptr;
+
+	// Flow field of the goal last steered towards, shared through the registry
+	TSharedPtr<FSVONavFlowField> FlowField;
+	TWeakObjectPtr<AActor> FlowFieldGoal;
+
 	// Called when the game starts
 	virtual void BeginPlay() override;
 	virtual bool CheckHieVolumeCondition(FSVONavLink& StartLink, FSVONavLink& TargetLink,
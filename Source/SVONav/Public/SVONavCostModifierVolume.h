@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Volume.h"
+#include "SVONavCostModifierVolume.generated.h"
+
+/**
+ * Raises the traversal cost of the navigation nodes it contains, baked into the nav volumes' cost field
+ */
+UCLASS(Blueprintable, meta=(DisplayName = "SVO Navigation Cost Modifier Volume"))
+class SVONAV_API ASVONavCostModifierVolume : public AVolume
+{
+	GENERATED_BODY()
+
+public:
+	ASVONavCostModifierVolume(const FObjectInitializer& ObjectInitializer);
+
+	// Multiplier on the cost of entering any node whose centre lies inside, the highest one wins where volumes overlap
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin = "1", ClampMax = "16.9"), Category = "SVONav|Cost")
+	float CostMultiplier = 4.f;
+};
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "SVONavComponent.h"
+#include "SVONavPathBatch.h"
 #include "SVONavType.h"
 #include "Async/Async.h"
 #include "Async/AsyncWork.h"
@@ -67,3 +68,40 @@ protected:
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FSVONavFindPathTask, STATGROUP_ThreadPoolAsyncTasks);
 	}
 };
+
+class FSVONavFindPathBatchTask : public FNonAbandonableTask
+{
+	friend class FAutoDeleteAsyncTask<FSVONavFindPathBatchTask>;
+
+public:
+	FSVONavFindPathBatchTask(
+		ASVONavVolume& InVolume,
+		ASVONavVolumeBase& InHieVolume,
+		UWorld* InWorld,
+		USVONavComponent* InNavComp,
+		const FSVONavPathBatchRef& InBatch)
+		: Volume(InVolume),
+		  HieVolume(InHieVolume),
+		  World(InWorld),
+		  NavComp(InNavComp),
+		  Batch(InBatch)
+	{
+	}
+
+protected:
+	ASVONavVolume& Volume;
+	ASVONavVolumeBase& HieVolume;
+	UWorld* World;
+	USVONavComponent* NavComp;
+	FSVONavPathBatchRef Batch;
+
+	void DoWork();
+
+	/* Ancestor of the target a few layers up, requests sharing it are solved by the same path finder */
+	FSVONavLink GetTargetRegion(const FSVONavLink& TargetLink) const;
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FSVONavFindPathBatchTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+};
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavOpenList.h"
+#include "SVONavSearchState.h"
+#include "SVONavType.h"
+#include "UObject/ObjectKey.h"
+
+class ASVONavVolume;
+
+/**
+ * Distance and next hop towards one goal for every node of the SVO volume within a radius, from a reverse Dijkstra.
+ * Any number of agents heading to the same goal sample it instead of searching. When the goal enters another node the
+ * shortest path tree is re-rooted: the part of the tree that already ran through the new goal node keeps its
+ * distances, offset by a constant, and only the rest is swept again.
+ */
+class SVONAV_API FSVONavFlowField
+{
+public:
+	explicit FSVONavFlowField(ASVONavVolume& InVolume);
+
+	FSVONavFlowField(const FSVONavFlowField&) = delete;
+	FSVONavFlowField& operator=(const FSVONavFlowField&) = delete;
+
+	/* Moves the goal, only touching the field when the goal entered another node. 0 sweeps the whole volume */
+	bool SetGoal(const FVector& GoalLocation, float InMaxDistance);
+
+	/* Next link towards the goal and the distance left, false when the field does not reach the link */
+	bool Sample(const FSVONavLink& Link, FSVONavLink& OutNextHop, float& OutDistance) const;
+
+	const FSVONavLink& GetGoalLink() const { return GoalLink; }
+	bool IsForVolume(const ASVONavVolume* InVolume) const { return &Volume == InVolume; }
+	int32 GetLastSweepCount() const { return LastSweepCount; }
+
+private:
+	ASVONavVolume& Volume;
+
+	// GScore is the distance to the goal, Parent the next hop and bClosed marks settled links
+	FSVONavSearchState State;
+	FSVONavOpenList OpenList;
+
+	// Every link the field reaches, in settle order
+	TArray<FSVONavLink> Reached;
+	TArray<FSVONavLink> Subtree;
+	TArray<FSVONavLink> Neighbours;
+
+	FSVONavLink GoalLink;
+	uint32 SearchRevision = 0;
+	float MaxDistance = 0.f;
+	int32 LastSweepCount = 0;
+	bool bBuilt = false;
+
+	void Rebuild();
+	bool Reroot(const FSVONavLink& NewGoalLink);
+	void Relax(const FSVONavLink& Link, float Distance);
+	void Sweep();
+};
+
+/**
+ * Flow fields shared by every nav component steering towards the same goal actor in the same volume.
+ * Fields are created on first request and live until Trim finds their goal or volume gone. Game thread only.
+ */
+class SVONAV_API FSVONavFlowFieldRegistry
+{
+public:
+	static FSVONavFlowFieldRegistry& Get();
+
+	TSharedRef<FSVONavFlowField> FindOrAdd(ASVONavVolume& Volume, const AActor* Goal);
+
+	/* Drops the fields whose goal actor or volume no longer exists */
+	void Trim();
+
+private:
+	TMap<TPair<FObjectKey, FObjectKey>, TSharedRef<FSVONavFlowField>> Fields;
+};
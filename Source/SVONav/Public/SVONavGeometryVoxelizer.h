@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+
+class ULandscapeHeightfieldCollisionComponent;
+
+/**
+ * Answers the rasterizer's box overlap queries from a snapshot of the level's collision geometry instead of the
+ * physics scene. Simple collision shapes are kept as solids, complex-as-simple static meshes and landscape heightfields
+ * as surface triangles. Movable components are gathered where they stand, the same as the physics scene sees them.
+ * The snapshot is read only once gathered, so queries are safe from the rasterizer's worker threads.
+ */
+class SVONAV_API FSVONavGeometryVoxelizer
+{
+public:
+	/* Copies the geometry of every component blocking Channel whose bounds overlap Bounds */
+	void Gather(const UWorld* World, const FBox& Bounds, ECollisionChannel Channel);
+
+	/* True if any gathered geometry overlaps the box, the same answer a physics box overlap would give */
+	bool IsBlocked(const FVector& Centre, const FVector& Extent) const;
+
+	/* True if the box lies entirely inside one gathered solid, so every box within it is blocked too */
+	bool IsContained(const FVector& Centre, const FVector& Extent) const;
+
+	int32 GetTriangleCount() const { return Triangles.Num() / 3; }
+	int32 GetSolidCount() const { return Solids.Num(); }
+
+private:
+	enum class ESolidType : uint8
+	{
+		Convex,
+		Sphere,
+		Capsule
+	};
+
+	struct FSolid
+	{
+		ESolidType Type;
+		FBox Bounds;
+		// Convex: range in Planes. Sphere and capsule: segment end points, the same point for a sphere
+		int32 FirstPlane = 0;
+		int32 NumPlanes = 0;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		float Radius = 0.f;
+	};
+
+	// Three vertices per triangle
+	TArray<FVector> Triangles;
+	TArray<FPlane> Planes;
+	TArray<FSolid> Solids;
+
+	// Uniform grid over the gathered bounds, each cell lists the triangles and solids touching it
+	static constexpr int32 GridResolution = 32;
+	FBox GridBounds;
+	FVector CellSize = FVector::OneVector;
+	TArray<TArray<int32>> TriangleCells;
+	TArray<TArray<int32>> SolidCells;
+
+	void AddConvex(const TArray<FVector>& Vertices, const TArray<int32>& Indices);
+	void AddRoundSolid(const FVector& Start, const FVector& End, float Radius);
+	void AddTriangles(const TArray<FVector>& Vertices, const TArray<int32>& Indices);
+	void AddHeightfield(ULandscapeHeightfieldCollisionComponent* Component);
+	void BuildGrid();
+	bool GetCellRange(const FBox& Box, FIntVector& OutMin, FIntVector& OutMax) const;
+	int32 GetCellIndex(const int32 X, const int32 Y, const int32 Z) const
+	{
+		return (Z * GridResolution + Y) * GridResolution + X;
+	}
+
+	static bool TriangleBoxOverlap(const VectorRegister& Centre, const VectorRegister& Extent, const FVector* Vertices);
+	bool SolidBoxOverlap(const FSolid& Solid, const FVector& Centre, const FVector& Extent) const;
+	bool SolidContainsPoint(const FSolid& Solid, const FVector& Point) const;
+};
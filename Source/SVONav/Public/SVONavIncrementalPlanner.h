@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavOpenList.h"
+#include "SVONavSearchState.h"
+#include "SVONavType.h"
+#include "SVONavVolumeBase.h"
+
+class ASVONavVolume;
+
+/**
+ * Persistent Lifelong Planning A* search over the SVO volume, rooted at the agent and growing towards its goal.
+ * Between queries the search tree is kept: a moved goal only re-keys the open list, a start that moved along the
+ * tree keeps the subtree hanging off it, and links whose traversal changed are repaired locally, so a replan costs
+ * roughly the area that changed instead of a full A* run.
+ * State is sparse, each planner only holds the links its current tree reaches.
+ */
+class SVONAV_API FSVONavIncrementalPlanner
+{
+public:
+	explicit FSVONavIncrementalPlanner(ASVONavVolume& InVolume);
+
+	FSVONavIncrementalPlanner(const FSVONavIncrementalPlanner&) = delete;
+	FSVONavIncrementalPlanner& operator=(const FSVONavIncrementalPlanner&) = delete;
+
+	/* Repairs the previous search for the new start and goal, then writes the path. False if the goal is unreachable */
+	bool FindPath(const FSVONavLink& InStartLink,
+	              const FSVONavLink& InGoalLink,
+	              const FVector& StartLocation,
+	              const FVector& GoalLocation,
+	              const FSVONavPathFindingConfig& InConfig,
+	              FSVONavPathSharedPtr* Path);
+
+	/* Re-evaluates links whose cost or blocked state changed without the octree being rebuilt */
+	void NotifyLinksChanged(const TArray<FSVONavLink>& Links);
+
+	/* Drops the search tree, the next query starts from scratch */
+	void Reset() { bInitialised = false; }
+
+	bool IsForVolume(const ASVONavVolume* InVolume) const { return &Volume == InVolume; }
+	int32 GetLastExpansions() const { return LastExpansions; }
+
+private:
+	ASVONavVolume& Volume;
+	FSVONavPathFindingConfig Config;
+
+	FSVONavSearchState State;
+	FSVONavOpenList OpenList;
+
+	// Every link the current tree holds state for, pruned back to the live tree whenever the start moves
+	TArray<FSVONavLink> TouchedLinks;
+	TArray<FSVONavLink> SubtreeLinks;
+	TArray<FSVONavLink> Neighbours;
+	TArray<FSVONavLink> RhsNeighbours;
+	TArray<FSVONavPathPoint> PathPoints;
+
+	FSVONavLink StartLink;
+	FSVONavLink GoalLink;
+	FSVONavTargetCentreCache TargetCache;
+	uint32 OctreeRevision = 0;
+	uint32 CostRevision = 0;
+	int32 LastExpansions = 0;
+	bool bInitialised = false;
+
+	void Initialise(const FSVONavLink& InStartLink);
+	bool MoveStart(const FSVONavLink& NewStartLink);
+	bool ComputeShortestPath();
+	bool ConfigChanged(const FSVONavPathFindingConfig& InConfig) const;
+
+	FSVONavSearchNode& Touch(const FSVONavLink& Link, int32 NodeId);
+	void UpdateRhs(const FSVONavLink& Link, int32 NodeId);
+	void UpdateVertex(const FSVONavLink& Link, int32 NodeId);
+	float CalculateKey(const FSVONavSearchNode& Node, const FSVONavLink& Link);
+
+	void BuildPath(const FVector& StartLocation, const FVector& GoalLocation, FSVONavPathSharedPtr* Path);
+};
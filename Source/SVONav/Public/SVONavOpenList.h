@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavSearchState.h"
+#include "SVONavType.h"
+
+/**
+ * Indexed binary min-heap used as the open list by every SVONavPathFinder search loop.
+ * Entries are keyed by dense node id, each node's heap position lives in the bound FSVONavSearchState,
+ * so a node is queued at most once and pushing an already queued node with a lower score performs a decrease-key.
+ */
+class SVONAV_API FSVONavOpenList
+{
+public:
+	explicit FSVONavOpenList(FSVONavSearchState& InState)
+		: State(InState)
+	{
+	}
+
+	void Reset() { Heap.Reset(); }
+	void Reserve(const int32 Num) { Heap.Reserve(Num); }
+
+	bool IsEmpty() const { return Heap.Num() == 0; }
+	int32 Num() const { return Heap.Num(); }
+
+	bool Contains(const int32 NodeId) const
+	{
+		const FSVONavSearchNode* Node = State.Find(NodeId);
+		return Node && Node->HeapIndex != INDEX_NONE;
+	}
+
+	const FSVONavLink& Top() const { return Heap[0].Link; }
+	int32 GetTopId() const { return Heap[0].NodeId; }
+	float GetTopScore() const { return Heap.Num() > 0 ? Heap[0].Score : FLT_MAX; }
+
+	/* Inserts the node, or lowers its score if it is already queued with a higher one */
+	void Push(const FSVONavLink& Link, int32 NodeId, float Score);
+
+	/* Removes and returns the link with the lowest score */
+	FSVONavLink Pop();
+
+	/* Sets the node's score whether it rises or falls, inserting the node if it is not queued */
+	void Update(const FSVONavLink& Link, int32 NodeId, float Score);
+
+	/* Removes the node if it is queued */
+	void Remove(int32 NodeId);
+
+	/* Re-scores every queued node and restores the heap order in linear time */
+	void Rebuild(TFunctionRef<float(const FSVONavLink& Link, int32 NodeId)> Score);
+
+private:
+	struct FEntry
+	{
+		FSVONavLink Link;
+		int32 NodeId;
+		float Score;
+	};
+
+	FSVONavSearchState& State;
+	TArray<FEntry> Heap;
+
+	void SiftUp(int32 Index);
+	void SiftDown(int32 Index);
+
+	void Place(const int32 Index, const FEntry& Entry)
+	{
+		Heap[Index] = Entry;
+		State.Get(Entry.NodeId).HeapIndex = Index;
+	}
+};
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavType.h"
+
+struct SVONAV_API FSVONavPathRequest
+{
+	FVector StartLocation = FVector::ZeroVector;
+	FVector TargetLocation = FVector::ZeroVector;
+	FSVONavPathFindingConfig Config;
+};
+
+struct SVONAV_API FSVONavPathBatchResult
+{
+	FSVONavPathSharedPtr Path;
+	ESVONavPathFindingCallResult Result = ESVONavPathFindingCallResult::Success;
+	bool bPathFound = false;
+};
+
+/**
+ * Path requests solved together on the worker threads. Requests are grouped by target region and config, each group
+ * runs on one path finder so its searches share a warm search context and the target centre caches, and the groups
+ * are spread over the workers. Results only become visible once the whole batch is complete.
+ */
+struct SVONAV_API FSVONavPathBatch
+{
+	TArray<FSVONavPathRequest> Requests;
+	// Same order as Requests
+	TArray<FSVONavPathBatchResult> Results;
+
+	// Links resolved on the game thread, invalid where a request failed before searching
+	TArray<FSVONavLink> StartLinks;
+	TArray<FSVONavLink> TargetLinks;
+
+	bool IsComplete() const { return bComplete; }
+
+	FThreadSafeBool bComplete = false;
+};
+
+using FSVONavPathBatchRef = TSharedRef<FSVONavPathBatch, ESPMode::ThreadSafe>;
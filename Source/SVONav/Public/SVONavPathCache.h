@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "SVONavType.h"
+
+class ASVONavVolumeBase;
+
+struct FSVONavPathCacheKey
+{
+	const ASVONavVolumeBase* Volume;
+	FSVONavLink StartLink;
+	FSVONavLink TargetLink;
+	// The search settings are compared in full, the hash only picks the bucket
+	FSVONavPathFindingConfig Config;
+	uint32 ConfigHash;
+
+	FSVONavPathCacheKey(const ASVONavVolumeBase& InVolume,
+	                    const FSVONavLink& InStartLink,
+	                    const FSVONavLink& InTargetLink,
+	                    const FSVONavPathFindingConfig& InConfig);
+
+	bool operator==(const FSVONavPathCacheKey& Other) const
+	{
+		return Volume == Other.Volume && StartLink == Other.StartLink && TargetLink == Other.TargetLink &&
+			ConfigHash == Other.ConfigHash && Config.HasSameSearch(Other.Config);
+	}
+
+	friend uint32 GetTypeHash(const FSVONavPathCacheKey& Key)
+	{
+		return HashCombine(HashCombine(PointerHash(Key.Volume), GetTypeHash(Key.StartLink)),
+		                   HashCombine(GetTypeHash(Key.TargetLink), Key.ConfigHash));
+	}
+};
+
+/**
+ * Process wide least recently used cache of raw search results, before pruning and smoothing.
+ * Entries remember the octree revision of the volume they were searched on. An update, rebuild or load bumps the
+ * revision, which turns every older entry of that volume into a miss without walking the cache.
+ * Lookups and inserts are guarded by a lock, so the async find path tasks share it freely.
+ */
+class SVONAV_API FSVONavPathCache
+{
+public:
+	static FSVONavPathCache& Get();
+
+	/* Copies the cached points into OutPoints, false when there is no entry for the volume's current revision */
+	bool Find(const FSVONavPathCacheKey& Key, uint32 Revision, TArray<FSVONavPathPoint>& OutPoints);
+
+	/* Stores the points of a successful search, evicting the least recently used entry when full */
+	void Add(const FSVONavPathCacheKey& Key, uint32 Revision, const TArray<FSVONavPathPoint>& Points);
+
+	/* Drops every entry, and resizes the cache when a capacity is given */
+	void Empty(int32 Capacity = INDEX_NONE);
+
+	int32 Num();
+
+private:
+	struct FEntry
+	{
+		uint32 Revision = 0;
+		TArray<FSVONavPathPoint> Points;
+	};
+
+	FSVONavPathCache();
+
+	FCriticalSection Lock;
+	TLruCache<FSVONavPathCacheKey, FEntry> Entries;
+};
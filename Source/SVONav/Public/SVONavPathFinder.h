@@ -1,9 +1,11 @@
 ﻿#pragma once
 
 #include "SVONavComponent.h"
+#include "SVONavSearchContext.h"
 #include "SVONavType.h"
 
 class ASVONavVolume;
+class ASVONavVolumeHierarchical;
 
 class SVONAV_API SVONavPathFinder
 {
@@ -17,14 +19,22 @@ public:
 		  NavComp(InNavComp),
 		  SVOVolume(InNavVolume),
 		  HieVolume(InHieVolume),
-		  Config(InConfig)
+		  Config(InConfig),
+		  Context(FSVONavSearchContextPool::Get().Acquire()),
+		  SearchState(Context.SearchState),
+		  OpenList(Context.OpenList),
+		  TargetSet(Context.TargetSet)
 	{
 	};
 
 	~SVONavPathFinder()
 	{
+		FSVONavSearchContextPool::Get().Release(Context);
 	};
 
+	SVONavPathFinder(const SVONavPathFinder&) = delete;
+	SVONavPathFinder& operator=(const SVONavPathFinder&) = delete;
+
 	/* Performs an A* search from start to target navlink */
 	int FindPath(const FSVONavLink& StartLink,
 	             const FSVONavLink& TargetLink,
@@ -34,6 +44,48 @@ public:
 	             FSVONavPathSharedPtr* Path
 	);
 
+	/* Starts an A* search over the SVO volume that StepAStar advances one slice at a time */
+	void BeginAStar(const FSVONavLink& StartLink, const FSVONavLink& TargetLink);
+
+	/* Advances the search until it finishes or a budget is spent, 0 disables the expansion or time budget */
+	ESVONavPathQueryStatus StepAStar(int32 MaxExpansions, double EndTime,
+	                                 const FVector& StartLocation,
+	                                 const FVector& TargetLocation,
+	                                 FSVONavPathSharedPtr* Path);
+
+	/* Starts an anytime repairing A* search over the SVO volume that StepAnytime advances one slice at a time */
+	void BeginAnytime(const FSVONavLink& StartLink, const FSVONavLink& TargetLink);
+
+	/* Advances the search like StepAStar. Every cheaper path found is written to Path straight away, Improving is
+	 * returned while the configured improvement budget allows further passes */
+	ESVONavPathQueryStatus StepAnytime(int32 MaxExpansions, double EndTime,
+	                                   const FVector& StartLocation,
+	                                   const FVector& TargetLocation,
+	                                   FSVONavPathSharedPtr* Path);
+
+	int32 GetExpansions() const { return Expansions; }
+	float GetAnytimePathCost() const { return AnytimePathCost; }
+
+	/* One A* search towards every target at once, writes the path to whichever is nearest by travel and its index.
+	 * The search uses an admissible estimate whatever the configured heuristic and weight, TargetLocations must
+	 * match TargetLinks one for one */
+	int FindPathToNearest(const FSVONavLink& StartLink,
+	                      const TArray<FSVONavLink>& TargetLinks,
+	                      const FVector& StartLocation,
+	                      const TArray<FVector>& TargetLocations,
+	                      FSVONavPathSharedPtr* Path,
+	                      int32& OutTargetIndex);
+
+	/* Travel cost between two links over the SVO volume, no path is built. Negative if unreachable.
+	 * A* with an admissible estimate whatever the configured heuristic and weight, so the cost matches FindCostMatrix */
+	float FindPathCost(const FSVONavLink& StartLink, const FSVONavLink& TargetLink);
+
+	/* Travel costs from every start to every target, row major by start, negative where unreachable.
+	 * Runs one search per distinct link of the smaller side, each stopping once the other side is settled */
+	void FindCostMatrix(const TArray<FSVONavLink>& StartLinks,
+	                    const TArray<FSVONavLink>& TargetLinks,
+	                    TArray<float>& OutCosts);
+
 	void ApplyPathPruning(FSVONavPathSharedPtr* InPath, const FSVONavPathFindingConfig InConfig) const;
 	void ApplyPathLineOfSight(FSVONavPathSharedPtr* InPath, AActor* Target, float MinimumDistance) const;
 	static void ApplyPathSmoothing(FSVONavPathSharedPtr* InPath, FSVONavPathFindingConfig Config);
@@ -46,16 +98,27 @@ public:
 
 private:
 	// Initialise
-	TSet<FSVONavLink> TargetSet;
-	TSet<FSVONavLink> OpenSet;
-	TSet<FSVONavLink> ClosedSet;
-	TMap<FSVONavLink, FSVONavLink> Parent;
-	TMap<FSVONavLink, float> GScore;
-	TMap<FSVONavLink, float> FScore;
-
 	FSVONavLink StartLink = FSVONavLink();
 	FSVONavLink CurrentLink = FSVONavLink();
 	FSVONavLink TargetLink = FSVONavLink();
+	int32 CurrentId = INDEX_NONE;
+	int32 Expansions = 0;
+
+	// Anytime search progress kept between steps, the time is what the steps have spent so far
+	float AnytimeWeight = 1.f;
+	float AnytimePathCost = FLT_MAX;
+	double AnytimeSeconds = 0.0;
+
+	// Heuristic target centres, looked up once per query rather than once per evaluation
+	FSVONavTargetCentreCache SVOTargetCache;
+	FSVONavTargetCentreCache HieTargetCache;
+
+	// Region tables of the hierarchical volume while a portal search runs
+	const ASVONavVolumeHierarchical* PortalVolume = nullptr;
+
+	// Jump point search
+	FSVONavLeafCellCache LeafCellCache;
+	FIntVector JumpTargetCell = FIntVector(-1);
 
 	UWorld* World;
 	USVONavComponent* NavComp;
@@ -63,17 +126,57 @@ private:
 	ASVONavVolumeBase& HieVolume;
 	FSVONavPathFindingConfig& Config;
 
+	// Borrowed from the context pool for the lifetime of the path finder
+	FSVONavSearchContext& Context;
+	FSVONavSearchState& SearchState;
+	FSVONavOpenList& OpenList;
+	TSet<FSVONavLink>& TargetSet;
+
+	/* Resets the search state for a new search over the given volume and queues the start link */
+	void BeginSearch(const ASVONavVolumeBase& Volume, const FSVONavLink& InStartLink, float StartScore);
+
+	/* Pops the lowest score link into CurrentLink and closes it */
+	void PopCurrent();
+
+	/* Parent of a link reached by the current search, false at the search root or an unreached link */
+	bool GetParentLink(const ASVONavVolumeBase& Volume, const FSVONavLink& Link, FSVONavLink& OutParent) const
+	{
+		return GetParentLink(SearchState, Volume, Link, OutParent);
+	}
+
+	static bool GetParentLink(const FSVONavSearchState& State, const ASVONavVolumeBase& Volume,
+	                          const FSVONavLink& Link, FSVONavLink& OutParent);
+
 	/* A* heuristic calculation */
 	float HeuristicScore(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink);
 
 	float HeuristicScoreHie(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink);
 
+	/* Copy of the config whose straight line estimate never overshoots the travel cost to any of the targets */
+	FSVONavPathFindingConfig GetAdmissibleConfig(const TArray<FSVONavLink>& InTargetLinks) const;
+
+	/* FindPathToNearest and FindPathCost, run on a path finder holding the admissible config */
+	int SearchNearest(const FSVONavLink& StartLink,
+	                  const TArray<FSVONavLink>& TargetLinks,
+	                  const FVector& StartLocation,
+	                  const TArray<FVector>& TargetLocations,
+	                  FSVONavPathSharedPtr* Path,
+	                  int32& OutTargetIndex);
+	float SearchPathCost(const FSVONavLink& StartLink, const FSVONavLink& TargetLink);
+
+	/* Heuristic towards the closest of several targets */
+	float NearestHeuristicScore(const FSVONavLink& InLink, const TArray<FSVONavLink>& InTargetLinks);
+
 	/* Distance between two links */
 	float GetCost(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink);
 	float GetCostHie(const FSVONavLink& InStartLink, const FSVONavLink& InTargetLink);
 
 	void ProcessLink(const FSVONavLink& NeighbourLink);
 	void ProcessLinkHie(const FSVONavLink& NeighbourLink);
+	void ProcessLinkHie(const FSVONavLink& NeighbourLink, float Cost);
+
+	/* Portal search successors, the other portals of the current link's region plus its links out of the region */
+	void ExpandPortalLink(const FSVONavLink& InTargetLink);
 
 	int FindPathHierarchical(const FSVONavLink& StartLink,
 	                         const FSVONavLink& TargetLink,
@@ -91,6 +194,71 @@ private:
 	                  FSVONavPathSharedPtr* Path
 	);
 
+	int FindPathJumpPoint(const FSVONavLink& StartLink,
+	                      const FSVONavLink& TargetLink,
+	                      const FVector& StartLocation,
+	                      const FVector& TargetLocation,
+	                      FSVONavPathFindingConfig Config,
+	                      FSVONavPathSharedPtr* Path
+	);
+
+	/* Jumps from the current leaf sub node along the sub directions of the jump that reached it and towards its forced
+	 * neighbours, every way from the start */
+	void GetJumpSuccessors(TArray<FSVONavLink>& Successors);
+
+	/* Steps from a cell along a direction, true with the link of the first jump point or open node reached */
+	bool Jump(FIntVector Cell, const FIntVector& Direction, FSVONavLink& OutLink);
+
+	/* Neighbourhood bits of the neighbours only reached optimally through a cell entered along Direction, under the
+	 * canonical ordering of the jump point tables in SVONavPathFinder.cpp */
+	uint32 GetForcedNeighbours(const FIntVector& Cell, const FIntVector& Direction);
+
+	bool IsLeafCellBlocked(const FIntVector& Cell)
+	{
+		return SVOVolume.GetLeafCell(Cell, LeafCellCache) == ESVONavLeafCell::Blocked;
+	}
+
+	bool IsLeafSubNode(const FSVONavLink& Link) const;
+
+	int FindPathBidirectional(const FSVONavLink& StartLink,
+	                          const FSVONavLink& TargetLink,
+	                          const FVector& StartLocation,
+	                          const FVector& TargetLocation,
+	                          FSVONavPathFindingConfig Config,
+	                          FSVONavPathSharedPtr* Path
+	);
+
+	/* Expands the best link of one frontier and records any cheaper meeting point with the other */
+	void ExpandBidirectional(bool bForward, float& BestCost, FSVONavLink& MeetingLink);
+
+	/* Builds the path from the start to EndLink through the search parents, continuing on to the target through
+	 * the backward parents when a reverse state is given. Unlike BuildPath every visited link is kept */
+	void BuildPathThrough(const FSVONavLink& EndLink, const FSVONavSearchState* ReverseState,
+	                      const FVector& InStartLocation, const FVector& InTargetLocation, FSVONavPathSharedPtr* InPath);
+
+	int FindPathLazyTheta(const FSVONavLink& StartLink,
+	                      const FSVONavLink& TargetLink,
+	                      const FVector& StartLocation,
+	                      const FVector& TargetLocation,
+	                      FSVONavPathFindingConfig Config,
+	                      FSVONavPathSharedPtr* Path
+	);
+
+	int FindPathAnytime(const FSVONavLink& StartLink,
+	                    const FSVONavLink& TargetLink,
+	                    const FVector& StartLocation,
+	                    const FVector& TargetLocation,
+	                    FSVONavPathFindingConfig Config,
+	                    FSVONavPathSharedPtr* Path
+	);
+
+	/* One ARA* pass at the current weight, false if the expansion limit or end time was hit before the pass finished */
+	bool ImprovePathAnytime(int32 TargetId, int32 ExpansionLimit, double EndTime);
+
+	/* Lazy Theta* vertex check, re-parents the current link onto its best closed neighbour if its parent is not visible */
+	void SetVertexLazyTheta();
+	void ProcessLinkLazyTheta(const FSVONavLink& NeighbourLink);
+
 	int FindPathTesting(const FSVONavLink& StartLink,
 	                    const FSVONavLink& TargetLink,
 	                    const FVector& StartLocation,
@@ -99,12 +267,11 @@ private:
 	                    FSVONavPathSharedPtr* Path
 	);
 
-	/* Constructs the path by navigating back through our CameFrom map */
-	void BuildPath(TMap<FSVONavLink, FSVONavLink>& InParent, FSVONavLink InCurrentLink, const FVector& InStartLocation,
+	/* Constructs the path by navigating back through the search state parents */
+	void BuildPath(FSVONavLink InCurrentLink, const FVector& InStartLocation,
 	               const FVector& InTargetLocation, FSVONavPathSharedPtr* InPath);
 
-	void BuildHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InParent,
-	                           FSVONavLink TopStartLink,
+	void BuildHierarchicalPath(FSVONavLink TopStartLink,
 	                           FSVONavLink TopTargetLink,
 	                           FSVONavLink InStartLink,
 	                           FSVONavLink InTargetLink,
@@ -112,22 +279,26 @@ private:
 	                           const FVector& InStartLocation,
 	                           const FVector& InTargetLocation, FSVONavPathSharedPtr* InPath);
 	
-	void RollHierarchicalPath(TMap<FSVONavLink, FSVONavLink>& InParent,
-                               FSVONavLink InCurrentLink,
-                               FSVONavLink InStartLink,
-                               FSVONavLink InTargetLink,
-                               const FVector& StartLocation,
-								const FVector& TargetLocation,
-                               FSVONavPathSharedPtr* InPath,
-                               int32& PointIndex);
-
-	int RefineHierarchicalPath(FSVONavLink InStartLink,
-	                            FSVONavLink InTargetLink,
-	                            FSVONavPathSharedPtr* InPath,
-	                            int32 RefineIndex);
-
-
-	void BuildPathHie(TMap<FSVONavLink, FSVONavLink>& InParent, FSVONavLink InCurrentLink,
+	/* Refines every unrefined segment of a hierarchical path, the segments of each pass run in parallel */
+	void RefineHierarchicalPath(FSVONavPathSharedPtr* InPath);
+
+	/* The child of an unrefined point that both of its segments are refined towards */
+	FSVONavPathPoint GetJointPoint(const FSVONavPathPoint& Previous,
+	                               const FSVONavPathPoint& Point,
+	                               const FSVONavPathPoint& Next) const;
+
+	/* Writes the points strictly between two links of the hierarchical volume, stitched from the cached region routes
+	 * when it can and searched otherwise */
+	bool RefineHierarchicalSegment(const FSVONavLink& InStartLink,
+	                               const FSVONavLink& InTargetLink,
+	                               TArray<FSVONavPathPoint>& OutPoints);
+
+	/* Route between two links in the same or in adjacent regions from the region tables, false if none is cached */
+	bool StitchRegionRoute(const FSVONavLink& InStartLink,
+	                       const FSVONavLink& InTargetLink,
+	                       TArray<FSVONavPathPoint>& OutPoints) const;
+
+	void BuildPathHie(FSVONavLink InCurrentLink,
 	                  const FVector& InStartLocation,
 	                  const FVector& InTargetLocation, FSVONavPathSharedPtr* InPath);
 };
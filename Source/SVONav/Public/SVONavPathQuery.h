@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavType.h"
+
+class ASVONavVolume;
+class ASVONavVolumeBase;
+class SVONavPathFinder;
+class USVONavComponent;
+
+/**
+ * A path request that runs on the calling thread in budgeted slices instead of to completion.
+ * The query keeps its path finder, and with it a pooled search context, until it is destroyed, so a search can be
+ * suspended at the end of one frame and continued on the next. Only the algorithms SupportsAlgorithm accepts can be
+ * sliced, they run over the SVO volume. An anytime query writes its first path as soon as it has one, reports Improving,
+ * and rewrites the same path in place each time a later step finds a cheaper one.
+ */
+class SVONAV_API FSVONavPathQuery
+{
+public:
+	FSVONavPathQuery(UWorld* InWorld,
+	                 USVONavComponent* InNavComp,
+	                 ASVONavVolume& InVolume,
+	                 ASVONavVolumeBase& InHieVolume,
+	                 const FSVONavPathFindingConfig& InConfig,
+	                 const FSVONavLink& InStartLink,
+	                 const FSVONavLink& InTargetLink,
+	                 const FVector& InStartLocation,
+	                 const FVector& InTargetLocation,
+	                 FSVONavPathSharedPtr* InPath);
+	~FSVONavPathQuery();
+
+	FSVONavPathQuery(const FSVONavPathQuery&) = delete;
+	FSVONavPathQuery& operator=(const FSVONavPathQuery&) = delete;
+
+	/* Runs the search until it finishes or a budget is spent, 0 disables the expansion or microsecond budget */
+	ESVONavPathQueryStatus Step(int32 MaxExpansions, float MaxMicroseconds);
+
+	/* Whether a query can step the algorithm, the rest only run to completion through FindPath */
+	static bool SupportsAlgorithm(ESVONavAlgorithm Algorithm);
+
+	ESVONavPathQueryStatus GetStatus() const { return Status; }
+	bool IsComplete() const
+	{
+		return Status == ESVONavPathQueryStatus::Succeeded || Status == ESVONavPathQueryStatus::Failed;
+	}
+	bool HasPath() const
+	{
+		return Status == ESVONavPathQueryStatus::Improving || Status == ESVONavPathQueryStatus::Succeeded;
+	}
+	int32 GetExpansions() const;
+
+private:
+	// Owned here, the path finder only keeps a reference to it
+	FSVONavPathFindingConfig Config;
+	TUniquePtr<SVONavPathFinder> PathFinder;
+
+	FVector StartLocation;
+	FVector TargetLocation;
+	FSVONavPathSharedPtr* Path;
+	// Cost of the path last post processed, an anytime search lowers it pass by pass
+	float PathCost = FLT_MAX;
+	ESVONavPathQueryStatus Status = ESVONavPathQueryStatus::InProgress;
+};
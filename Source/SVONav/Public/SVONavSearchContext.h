@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavOpenList.h"
+#include "SVONavSearchState.h"
+#include "SVONavType.h"
+
+/**
+ * Everything a single search needs that would otherwise be allocated per request.
+ * Containers are only ever Reset, so once a context has served a query of a given size it serves the next one
+ * without touching the heap.
+ */
+struct SVONAV_API FSVONavSearchContext
+{
+	FSVONavSearchContext()
+		: OpenList(SearchState),
+		  ReverseOpenList(ReverseSearchState)
+	{
+		Neighbours.Reserve(64);
+		PathPoints.Reserve(64);
+	}
+
+	FSVONavSearchContext(const FSVONavSearchContext&) = delete;
+	FSVONavSearchContext& operator=(const FSVONavSearchContext&) = delete;
+
+	FSVONavSearchState SearchState;
+	FSVONavOpenList OpenList;
+	TSet<FSVONavLink> TargetSet;
+
+	// Closed links of the current anytime pass and links improved after being closed
+	TArray<int32> ClosedIds;
+	TArray<FSVONavLink> InconsistentLinks;
+
+	// Backward frontier of bidirectional searches
+	FSVONavSearchState ReverseSearchState;
+	FSVONavOpenList ReverseOpenList;
+
+	// Scratch storage for neighbour expansion and path reconstruction
+	TArray<FSVONavLink> Neighbours;
+	TArray<FSVONavPathPoint> PathPoints;
+	FSVONavPath ScratchPath;
+
+	// Hierarchical refinement, the segments of a pass and their interior points before they are spliced in
+	TArray<int32> RefineSegments;
+	TArray<TArray<FSVONavPathPoint>> SegmentPoints;
+	TArray<FSVONavPathPoint> SplicedPoints;
+};
+
+/**
+ * Process wide pool of search contexts shared by the async find path tasks and immediate queries.
+ * The pool grows to the peak number of concurrent searches, roughly one context per worker thread, and keeps them.
+ */
+class SVONAV_API FSVONavSearchContextPool
+{
+public:
+	static FSVONavSearchContextPool& Get();
+
+	/* Borrows a context, creating one only when every pooled context is in use */
+	FSVONavSearchContext& Acquire();
+
+	/* Returns a borrowed context to the pool */
+	void Release(FSVONavSearchContext& Context);
+
+	/* Frees every idle context */
+	void Trim();
+
+private:
+	FCriticalSection Lock;
+	TArray<TUniquePtr<FSVONavSearchContext>> Contexts;
+	TArray<FSVONavSearchContext*> FreeContexts;
+};
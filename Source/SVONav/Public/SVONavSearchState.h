@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONavType.h"
+
+struct FSVONavSearchNode
+{
+	float GScore;
+	float FScore;
+	// One step lookahead cost used by the incremental planner, FLT_MAX elsewhere
+	float Rhs;
+	FSVONavLink Parent;
+	// Position in the open list heap, INDEX_NONE when not queued
+	int32 HeapIndex;
+	uint32 Generation;
+	bool bClosed;
+};
+
+/**
+ * Per-node search bookkeeping stored contiguously and indexed by the volume's dense node ids.
+ * Nodes are stamped with the generation of the search that last touched them, so starting a new search is O(1):
+ * stale entries are reset lazily the first time they are accessed.
+ * A sparse search instead maps ids to nodes allocated on first touch, for long lived searches that should only hold
+ * the nodes they reached. Sparse nodes never move, so references stay valid as the search grows.
+ */
+class SVONAV_API FSVONavSearchState
+{
+public:
+	/* Starts a new search over NumNodes node ids */
+	void Begin(const int32 NumNodes)
+	{
+		if (bSparse)
+		{
+			bSparse = false;
+			SparseSlots.Empty();
+			SparseChunks.Empty();
+			FreeSlots.Empty();
+		}
+		if (Nodes.Num() < NumNodes) Nodes.SetNumZeroed(NumNodes, false);
+		if (++Generation == 0)
+		{
+			// Generation wrapped, clear every stamp so no node looks current
+			for (FSVONavSearchNode& Node : Nodes) Node.Generation = 0;
+			Generation = 1;
+		}
+	}
+
+	/* Starts a new sparse search, only the nodes it touches take memory */
+	void BeginSparse()
+	{
+		Nodes.Empty();
+		SparseSlots.Reset();
+		SparseChunks.Reset();
+		FreeSlots.Reset();
+		bSparse = true;
+		Generation = 1;
+	}
+
+	/* Returns the node, resetting it first if it was last touched by an earlier search */
+	FORCEINLINE FSVONavSearchNode& Get(const int32 NodeId)
+	{
+		FSVONavSearchNode& Node = bSparse ? GetSparse(NodeId) : Nodes[NodeId];
+		if (Node.Generation != Generation)
+		{
+			Node.GScore = FLT_MAX;
+			Node.FScore = FLT_MAX;
+			Node.Rhs = FLT_MAX;
+			Node.Parent = FSVONavLink();
+			Node.HeapIndex = INDEX_NONE;
+			Node.Generation = Generation;
+			Node.bClosed = false;
+		}
+		return Node;
+	}
+
+	/* Returns the node if the current search has touched it, nullptr otherwise */
+	FORCEINLINE const FSVONavSearchNode* Find(const int32 NodeId) const
+	{
+		return const_cast<FSVONavSearchState*>(this)->Find(NodeId);
+	}
+
+	FORCEINLINE FSVONavSearchNode* Find(const int32 NodeId)
+	{
+		if (bSparse)
+		{
+			const int32* Slot = SparseSlots.Find(NodeId);
+			return Slot ? &GetSlot(*Slot) : nullptr;
+		}
+		return Nodes.IsValidIndex(NodeId) && Nodes[NodeId].Generation == Generation ? &Nodes[NodeId] : nullptr;
+	}
+
+	/* Makes the node look untouched again, a sparse search also frees its memory for reuse */
+	void Forget(const int32 NodeId)
+	{
+		if (!bSparse)
+		{
+			if (Nodes.IsValidIndex(NodeId)) Nodes[NodeId].Generation = 0;
+			return;
+		}
+		int32 Slot;
+		if (SparseSlots.RemoveAndCopyValue(NodeId, Slot)) FreeSlots.Add(Slot);
+	}
+
+	/* Nodes held, every node id for a dense search and only the touched ones for a sparse search */
+	int32 Num() const { return bSparse ? SparseSlots.Num() : Nodes.Num(); }
+
+private:
+	static constexpr int32 SparseChunkSize = 256;
+
+	TArray<FSVONavSearchNode> Nodes;
+	uint32 Generation = 0;
+	bool bSparse = false;
+	// Sparse search storage, chunks are never reallocated once created
+	TMap<int32, int32> SparseSlots;
+	TArray<TArray<FSVONavSearchNode>> SparseChunks;
+	TArray<int32> FreeSlots;
+
+	FORCEINLINE FSVONavSearchNode& GetSlot(const int32 Slot)
+	{
+		return SparseChunks[Slot / SparseChunkSize][Slot % SparseChunkSize];
+	}
+
+	FSVONavSearchNode& GetSparse(const int32 NodeId)
+	{
+		if (const int32* Slot = SparseSlots.Find(NodeId)) return GetSlot(*Slot);
+
+		int32 Slot;
+		if (FreeSlots.Num() > 0)
+		{
+			Slot = FreeSlots.Pop(false);
+		}
+		else
+		{
+			if (SparseChunks.Num() == 0 || SparseChunks.Last().Num() == SparseChunkSize)
+			{
+				SparseChunks.AddDefaulted_GetRef().Reserve(SparseChunkSize);
+			}
+			Slot = (SparseChunks.Num() - 1) * SparseChunkSize + SparseChunks.Last().Num();
+			SparseChunks.Last().AddUninitialized();
+		}
+		SparseSlots.Add(NodeId, Slot);
+
+		// Stale stamp, Get resets the node
+		FSVONavSearchNode& Node = GetSlot(Slot);
+		Node.Generation = 0;
+		return Node;
+	}
+};
@@ -30,7 +30,15 @@ public:
     UPROPERTY(EditAnywhere, Category=SVONav)
     class USVONavComponent* NavComponent;
 
+	// Number of times each query is repeated when benchmarking
+	UPROPERTY(EditAnywhere, Category=SVONav, meta=(ClampMin = "1"))
+	int32 BenchmarkIterations = 20;
+
 #if WITH_EDITOR
+	// Run the path query to the paired test actor repeatedly and log expansions and average time, compared to Greedy A*
+	UFUNCTION(CallInEditor, Category=SVONav)
+	void BenchmarkPathfinding();
+
 	virtual void EditorApplyTranslation(const FVector& DeltaTranslation, bool bAltDown, bool bShiftDown, bool bCtrlDown) override;
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 	virtual void PostEditUndo() override;
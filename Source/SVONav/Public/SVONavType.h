@@ -132,6 +132,115 @@ FORCEINLINE FArchive& operator<<(FArchive& Archive, FSVONavLeafNode& Leaf)
 	return Archive;
 }
 
+// State of a cell in the global leaf sub node grid
+enum class ESVONavLeafCell : uint8
+{
+	Blocked, // Occluded sub node or outside the volume
+	Free,	 // Free sub node of a rasterized leaf
+	Open	 // Free space that is not subdivided into sub nodes, covered by a single larger node
+};
+
+// Small direct mapped cache of layer 0 node lookups, owned by whoever walks the leaf sub node grid
+struct SVONAV_API FSVONavLeafCellCache
+{
+	mortoncode_t Codes[8];
+	int32 Indices[8];
+
+	FSVONavLeafCellCache() { Reset(); }
+	void Reset() { for (mortoncode_t& Code : Codes) Code = MAX_uint64; }
+};
+
+// Blocked codes of one octree layer while it is rasterized, sorted and unique. Layers whose bitset is no larger than
+// the code array also keep one, so probes for absent codes are a single bit test
+struct SVONAV_API FSVONavOccupancyLayer
+{
+	TArray<mortoncode_t> Codes;
+	TBitArray<> Bits;
+	int64 NumLayerCodes = 0;
+
+	// Takes codes that are already sorted and unique
+	void Set(TArray<mortoncode_t>&& InCodes, const int64 InNumLayerCodes)
+	{
+		Codes = MoveTemp(InCodes);
+		NumLayerCodes = InNumLayerCodes;
+		Bits.Empty();
+		if (NumLayerCodes > static_cast<int64>(Codes.Num()) * 64) return;
+		Bits.Init(false, static_cast<int32>(NumLayerCodes));
+		for (const mortoncode_t Code : Codes) Bits[Code] = true;
+	}
+
+	// The codes of the layer above, sorted children share their parent so duplicates are adjacent
+	void SetParentsOf(const FSVONavOccupancyLayer& Children)
+	{
+		TArray<mortoncode_t> Parents;
+		Parents.Reserve(Children.Codes.Num() / 4 + 1);
+		for (const mortoncode_t Code : Children.Codes)
+		{
+			if (Parents.Num() == 0 || Parents.Last() != Code >> 3) Parents.Add(Code >> 3);
+		}
+		Set(MoveTemp(Parents), FMath::Max<int64>(Children.NumLayerCodes / 8, 1));
+	}
+
+	int32 Num() const { return Codes.Num(); }
+
+	// Position of Code in Codes or INDEX_NONE. Gallops forward from Cursor, which is left at the probe, so ascending
+	// probes cost the log of the distance between them
+	int32 IndexOf(const mortoncode_t Code, int32& Cursor) const
+	{
+		if (Codes.Num() == 0) return INDEX_NONE;
+		if (Bits.Num() > 0 && (Code >= static_cast<mortoncode_t>(Bits.Num()) || !Bits[Code])) return INDEX_NONE;
+		if (Cursor < 0 || Cursor >= Codes.Num() || Codes[Cursor] > Code) Cursor = 0;
+
+		int32 Step = 1;
+		int32 Low = Cursor;
+		int32 High = Cursor;
+		while (High < Codes.Num() && Codes[High] < Code)
+		{
+			Low = High + 1;
+			High = Cursor + Step;
+			Step *= 2;
+		}
+		High = FMath::Min(High, Codes.Num() - 1);
+
+		while (Low <= High)
+		{
+			const int32 Mid = (Low + High) / 2;
+			if (Codes[Mid] < Code) Low = Mid + 1;
+			else if (Codes[Mid] > Code) High = Mid - 1;
+			else return Cursor = Mid;
+		}
+		Cursor = FMath::Min(Low, Codes.Num() - 1);
+		return INDEX_NONE;
+	}
+};
+
+// Node centres of one octree layer, one array per axis so distance evaluation is straight loads
+struct SVONAV_API FSVONavNodeCentres
+{
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+	// Layer 0 only, set for nodes whose sub nodes are rasterized
+	TArray<bool> HasLeaf;
+};
+
+// Cached all-pairs routes between the children of one hierarchical parent node, the region's abstract graph
+struct SVONAV_API FSVONavRegionTable
+{
+	// The parent's children, indexed by member index
+	TArray<FSVONavLink> Members;
+	// Members with a neighbour outside the region
+	TArray<bool> IsPortal;
+	// Members.Num() squared, row major. Centre to centre distance of the cheapest route inside the region, every step
+	// scaled by the cost field of the member it enters
+	TArray<float> Costs;
+	// Member after From on the shortest route from From to To, INDEX_NONE when To is unreachable
+	TArray<int32> NextHop;
+
+	FORCEINLINE float GetCost(const int32 From, const int32 To) const { return Costs[From * Members.Num() + To]; }
+	FORCEINLINE int32 GetNextHop(const int32 From, const int32 To) const { return NextHop[From * Members.Num() + To]; }
+};
+
 struct SVONAV_API FSVOHieNode
 {
 	mortoncode_t MortonCode;
@@ -266,6 +375,77 @@ FORCEINLINE FArchive& operator<<(FArchive& Ar, FSVOHieOctree& Octree)
 	return Ar;
 }
 
+// Versions of the data a volume serializes next to its octree
+struct SVONAV_API FSVONavCustomVersion
+{
+	enum Type
+	{
+		BeforeCustomVersion = 0,
+		LandmarkTables,
+		CostFields,
+		CompactNodeIds,
+		LandmarkRanges,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+};
+
+// Path lengths from a few landmark links to every node of the stored layers, baked with the octree
+struct SVONAV_API FSVONavLandmarkTable
+{
+	TArray<FSVONavLink> Landmarks;
+	// Node id count of the octree the table was baked for, anything else means the table is stale
+	int32 NodeIdCount = 0;
+	// Lowest layer with stored distances, links below it are looked up through their ancestor on it
+	int32 StoredLayer = 0;
+	int32 FirstNodeId = 0;
+	// Landmark major, nearest and farthest distance over the links an entry stands for. Searched links stand for
+	// themselves, subdivided nodes for the links below them. FLT_MAX where the landmark cannot reach one of them
+	TArray<float> Distances;
+	TArray<float> MaxDistances;
+
+	void Reset()
+	{
+		Landmarks.Empty();
+		Distances.Empty();
+		MaxDistances.Empty();
+		NodeIdCount = 0;
+		StoredLayer = 0;
+		FirstNodeId = 0;
+	}
+
+	bool IsValid(const int32 InNodeIdCount) const { return Landmarks.Num() > 0 && NodeIdCount == InNodeIdCount; }
+	int32 GetStoredCount() const { return NodeIdCount - FirstNodeId; }
+	int32 GetSize() const
+	{
+		return (Distances.Num() + MaxDistances.Num()) * sizeof(float) + Landmarks.Num() * sizeof(FSVONavLink);
+	}
+
+	FORCEINLINE float Get(const int32 Landmark, const int32 NodeId) const
+	{
+		return Distances[Landmark * GetStoredCount() + NodeId - FirstNodeId];
+	}
+
+	FORCEINLINE float GetMax(const int32 Landmark, const int32 NodeId) const
+	{
+		return MaxDistances[Landmark * GetStoredCount() + NodeId - FirstNodeId];
+	}
+};
+
+FORCEINLINE FArchive& operator<<(FArchive& Ar, FSVONavLandmarkTable& Table)
+{
+	Ar << Table.Landmarks;
+	Ar << Table.NodeIdCount;
+	Ar << Table.StoredLayer;
+	Ar << Table.FirstNodeId;
+	Ar << Table.Distances;
+	if (Ar.CustomVer(FSVONavCustomVersion::GUID) >= FSVONavCustomVersion::LandmarkRanges) Ar << Table.MaxDistances;
+	return Ar;
+}
+
 //DEBUG
 
 USTRUCT(BlueprintType)
@@ -386,7 +566,7 @@ struct SVONAV_API FSVONavPathPoint
 	{
 	}
 
-	FSVONavLink GetLink()
+	FSVONavLink GetLink() const
 	{
 		FSVONavLink Link;
 		Link.SetLayerIndex(Layer);
@@ -405,6 +585,8 @@ struct SVONAV_API FSVONavPath
 
 	void Add(const FSVONavPathPoint& Point) { Points.Add(Point); }
 	void Empty() { Points.Empty(); }
+	// Clears the points but keeps the allocation for the next query
+	void Reset() { Points.Reset(); }
 	TArray<FSVONavPathPoint>& GetPoints() { return Points; }
 	void SetPoints(const TArray<FSVONavPathPoint> NewPoints) { Points = NewPoints; }
 	void GetPath(TArray<FVector>& Path) { for (const auto& Point : Points) { Path.Add(Point.Location); } }
@@ -433,14 +615,27 @@ enum class ESVONavAlgorithm: uint8
 {
 	HierarchicalAStar UMETA(DisplayName="Hierarchical A*"),
 	GreedyAStar UMETA(DisplayName="Greedy A*"),
-	Testing UMETA(DisplayName="Testing")
+	Testing UMETA(DisplayName="Testing"),
+	JumpPointSearch UMETA(DisplayName="Jump Point Search", ToolTip="Canonical jump point search over the leaf sub nodes, diagonals first. Free nodes above the leaves are expanded as in A*."),
+	BidirectionalAStar UMETA(DisplayName="Bidirectional A*"),
+	LazyThetaStar UMETA(DisplayName="Lazy Theta*"),
+	AnytimeAStar UMETA(DisplayName="Anytime Repairing A*"),
+	HierarchicalPortalAStar UMETA(DisplayName="Hierarchical Portal A*")
+};
+
+UENUM()
+enum class ESVONavRasterizer: uint8
+{
+	Physics UMETA(DisplayName="Physics", ToolTip="Box overlap queries against the physics scene."),
+	Geometry UMETA(DisplayName="Geometry", ToolTip="Triangle and shape tests against a snapshot of the static collision geometry, no physics scene needed.")
 };
 
 UENUM()
 enum class ESVONavHeuristic: uint8
 {
 	Manhattan UMETA(DisplayName="Manhattan"),
-	Euclidean UMETA(DisplayName="Euclidean")
+	Euclidean UMETA(DisplayName="Euclidean"),
+	Landmarks UMETA(DisplayName="Landmarks", ToolTip="Triangle inequality over the landmark distances baked with the octree, Euclidean when none are baked")
 };
 
 UENUM()
@@ -454,6 +649,15 @@ enum class ESVONavPathFindingCallResult: uint8
 	NoTarget UMETA(DisplayName="Target link not found", ToolTip="Failed to find target link.")
 };
 
+UENUM()
+enum class ESVONavPathQueryStatus: uint8
+{
+	InProgress UMETA(DisplayName="In Progress", ToolTip="The query ran out of budget and continues on the next step."),
+	Improving UMETA(DisplayName="Improving", ToolTip="A path was written, later steps keep replacing it with cheaper ones."),
+	Succeeded UMETA(DisplayName="Succeeded", ToolTip="A path to the target was found."),
+	Failed UMETA(DisplayName="Failed", ToolTip="The target cannot be reached.")
+};
+
 UENUM()
 enum class ESVONavFindLineOfSightCallResult: uint8
 {
@@ -502,6 +706,22 @@ struct SVONAV_API FSVONavPathFindingConfig
 	UPROPERTY(BlueprintReadWrite)
 	float UnitCost;
 
+	// Anytime search: how much the estimate weight drops after each improved solution, down to 1
+	UPROPERTY(BlueprintReadWrite)
+	float AnytimeWeightStep;
+
+	// Anytime search: node expansion budget across all passes, 0 for unlimited
+	UPROPERTY(BlueprintReadWrite)
+	int32 MaxExpansions;
+
+	// Anytime search: time budget in milliseconds across all passes, 0 for unlimited
+	UPROPERTY(BlueprintReadWrite)
+	float TimeBudget;
+
+	// Serve repeated searches between the same links from the shared path cache
+	UPROPERTY(BlueprintReadWrite)
+	bool UsePathCache;
+
 	FSVONavPathFindingConfig() :
 		EstimateWeight(5.0f),
 		NodeSizePreference(1.0f),
@@ -510,7 +730,32 @@ struct SVONAV_API FSVONavPathFindingConfig
 		PathPruning(ESVONavPathPruning::None),
 		PathSmoothing(3),
 		UseUnitCost(false),
-		UnitCost(1.0f)
+		UnitCost(1.0f),
+		AnytimeWeightStep(1.0f),
+		MaxExpansions(0),
+		TimeBudget(0.0f),
+		UsePathCache(false)
+	{
+	}
+
+	// Hash of every setting that changes the raw search result, pruning and smoothing run after it
+	uint32 GetSearchHash() const
+	{
+		uint32 Hash = HashCombine(GetTypeHash(static_cast<uint8>(Algorithm)), GetTypeHash(static_cast<uint8>(Heuristic)));
+		Hash = HashCombine(Hash, GetTypeHash(EstimateWeight));
+		Hash = HashCombine(Hash, GetTypeHash(NodeSizePreference));
+		Hash = HashCombine(Hash, GetTypeHash(UseUnitCost ? UnitCost : 0.f));
+		Hash = HashCombine(Hash, GetTypeHash(AnytimeWeightStep));
+		Hash = HashCombine(Hash, GetTypeHash(MaxExpansions));
+		return HashCombine(Hash, GetTypeHash(TimeBudget));
+	}
+
+	// True when every setting GetSearchHash covers matches, so both configs give the same raw search result
+	bool HasSameSearch(const FSVONavPathFindingConfig& Other) const
 	{
+		return Algorithm == Other.Algorithm && Heuristic == Other.Heuristic && EstimateWeight == Other.EstimateWeight &&
+			NodeSizePreference == Other.NodeSizePreference && UseUnitCost == Other.UseUnitCost &&
+			(!UseUnitCost || UnitCost == Other.UnitCost) && AnytimeWeightStep == Other.AnytimeWeightStep &&
+			MaxExpansions == Other.MaxExpansions && TimeBudget == Other.TimeBudget;
 	}
 };
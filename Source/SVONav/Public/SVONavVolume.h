@@ -28,6 +28,5 @@ private:
 	//octree generate
 	void InitRasterize();
 	void RasterizeLayer(layerindex_t LayerIndex);
-	void RasterizeLeaf(FVector NodeLocation, int32 LeafIndex);
 	void BuildLinks(layerindex_t LayerIndex);
 };
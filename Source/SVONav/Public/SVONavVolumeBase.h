@@ -33,6 +33,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Volume")
 	TEnumAsByte<ECollisionChannel> CollisionChannel;
 
+	// How occupancy is tested during octree generation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Volume")
+	ESVONavRasterizer Rasterizer = ESVONavRasterizer::Physics;
+
 	// The minimum distance away from any object traces to apply during octree generation
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Volume")
 	float Clearance = 0.f;
@@ -41,6 +45,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Volume")
 	float TickInterval = 0.2f;
 
+	// Landmarks baked with the octree for the Landmarks heuristic, 0 skips the bake
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin = "0", ClampMax = "32"), Category = "SVONav|Landmarks")
+	int32 NumLandmarks = 8;
+
+	// Megabytes the landmark distances may take, the lowest layers are left out first when they do not fit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin = "0"), Category = "SVONav|Landmarks")
+	float LandmarkMemoryBudget = 16.f;
+
 	// Draw distance for debug lines
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVONav|Debugging")
 	float DebugDistance = 20000.f;
@@ -123,6 +135,8 @@ public:
 
 	virtual void OnConstruction(const FTransform& Transform) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Destroyed() override;
 	virtual void Tick(float DeltaTime) override;
 	virtual void PostRegisterAllComponents() override;
 	virtual void PostUnregisterAllComponents() override;
@@ -164,9 +178,104 @@ public:
 	virtual void GetNeighbourLinks(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const;
 	//virtual void GetLowestLevelChildNeighbours(const FSVONavLink& Link, const FSVONavLink& NeighbourLink, TArray<FSVONavLink>& ChildNeighbourLinks) const;
 	void GetNeighbourLeaves(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const;
+	// Resets NeighbourLinks to the links a search steps to from Link, leaf sub nodes included
+	void GetSearchNeighbours(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const;
+	// Resets PredecessorLinks to the links a search steps to Link from. Adjacency is not symmetric across layers and
+	// leaves, so backward searches use this rather than GetSearchNeighbours
+	void GetSearchPredecessors(const FSVONavLink& Link, TArray<FSVONavLink>& PredecessorLinks) const;
 	int32 GetLayerCount() const {return Octree.Layers.Num();}
+
+	// Dense node ids flatten (layer, node, subnode) so search state can live in contiguous arrays. Layer 0 nodes with a
+	// leaf own one id per sub node, every other node owns a single id
+	int32 GetNodeIdCount() const { return NodeIdCount; }
+	FORCEINLINE int32 GetNodeId(const FSVONavLink& Link) const
+	{
+		if (Link.LayerIndex != 0) return NodeIdOffsets[Link.LayerIndex] + Link.NodeIndex;
+		if (LeafNodeIds.Num() == 0) return Link.NodeIndex;
+		const int32 FirstId = LeafNodeIds[Link.NodeIndex];
+		return LeafNodeIds[Link.NodeIndex + 1] - FirstId > 1 ? FirstId + Link.SubNodeIndex : FirstId;
+	}
+	// Cached equivalent of GetLinkLocation, valid once the octree is built or loaded
+	FORCEINLINE FVector GetLinkCentre(const FSVONavLink& Link) const
+	{
+		const FSVONavNodeCentres& Centres = NodeCentres[Link.LayerIndex];
+		FVector Location(Centres.X[Link.NodeIndex], Centres.Y[Link.NodeIndex], Centres.Z[Link.NodeIndex]);
+		if (Link.LayerIndex == 0 && Centres.HasLeaf.Num() > 0 && Centres.HasLeaf[Link.NodeIndex])
+		{
+			Location += SubNodeOffsets[Link.SubNodeIndex];
+		}
+		return Location;
+	}
+
+	// Multiplier on the cost of entering Link, baked from the cost modifier volumes overlapping it
+	FORCEINLINE float GetCostScale(const FSVONavLink& Link) const
+	{
+		return CostField.Num() == NodeIdCount ? 1.f + CostField[GetNodeId(Link)] * CostFieldStep : 1.f;
+	}
+	// Inverse of GetNodeId
+	FSVONavLink GetNodeLink(int32 NodeId) const;
+
+	// Search heuristic from Link to Target, shared by every search over the volume. TargetCentre is the centre of
+	// Target, looked up once per query through a FSVONavTargetCentreCache
+	FORCEINLINE float GetHeuristicScore(const FSVONavLink& Link, const FSVONavLink& Target, const FVector& TargetCentre,
+	                                    const FSVONavPathFindingConfig& Config) const
+	{
+		float Score;
+		const FVector Centre = GetLinkCentre(Link);
+		switch (Config.Heuristic)
+		{
+		case ESVONavHeuristic::Manhattan:
+			Score = FMath::Abs(TargetCentre.X - Centre.X) + FMath::Abs(TargetCentre.Y - Centre.Y) +
+				FMath::Abs(TargetCentre.Z - Centre.Z);
+			break;
+		case ESVONavHeuristic::Landmarks:
+			// The landmark bound only ever tightens the straight line distance
+			Score = FMath::Max(GetLandmarkDistance(Link, Target), (Centre - TargetCentre).Size());
+			break;
+		case ESVONavHeuristic::Euclidean:
+		default:
+			Score = (Centre - TargetCentre).Size();
+			break;
+		}
+		return Score * (1.0f - static_cast<float>(Target.GetLayerIndex()) / NumLayers * Config.NodeSizePreference);
+	}
+
+	// Search cost of stepping from a link onto one of its neighbours, shared by every search over the volume
+	FORCEINLINE float GetTraversalCost(const FSVONavLink& From, const FSVONavLink& To,
+	                                   const FSVONavPathFindingConfig& Config) const
+	{
+		const float Cost = Config.UseUnitCost ? Config.UnitCost : (GetLinkCentre(From) - GetLinkCentre(To)).Size();
+		return Cost * (1.0f - static_cast<float>(From.GetLayerIndex()) / NumLayers * Config.NodeSizePreference) *
+			GetCostScale(To);
+	}
+
+	/* Re-bakes the cost field after cost modifier volumes moved or changed, without rebuilding the octree */
+	UFUNCTION(BlueprintCallable, Category = "SVONav|Cost")
+	void UpdateCostField();
+	// Bumped by every UpdateCostField, GetCostChangedLinks holds the links the last one changed
+	uint32 GetCostRevision() const { return CostRevision; }
+	const TArray<FSVONavLink>& GetCostChangedLinks() const { return CostChangedLinks; }
+
+	// Lower bound on the path length between two links from the baked landmarks, negative when none are baked.
+	// Dynamic updates restore the cached octree and so the node ids the table was baked for
+	float GetLandmarkDistance(const FSVONavLink& StartLink, const FSVONavLink& TargetLink) const;
+
+	// False only when the two links are known to lie in disconnected regions
+	virtual bool IsReachable(const FSVONavLink& StartLink, const FSVONavLink& TargetLink) const { return true; }
+
+	// Bumped on every build, update and load, links and node ids from an older revision are stale
+	uint32 GetOctreeRevision() const { return OctreeRevision; }
+	// Changes whenever a search over the volume could return a different result
+	uint32 GetSearchRevision() const { return OctreeRevision + CostRevision; }
 	bool IsWithinBounds(const FVector Location) const { return GetBoundingBox().IsInside(Location); }
 
+	// Global leaf sub node grid, four cells per layer 0 node along each axis
+	FIntVector GetLeafCellCoord(const FSVONavLink& Link) const;
+	ESVONavLeafCell GetLeafCell(const FIntVector& Cell, FSVONavLeafCellCache& Cache, FSVONavLink* Link = nullptr) const;
+
+	// Segment visibility against the occluded leaf sub nodes, walking only the octree nodes the segment passes through
+	bool IsLineOfSight(const FVector& Start, const FVector& End) const;
+
 	//debug draw
 	void FlushDebugDraw() const;
 	void AddDebugNavPath(const FSVONavDebugPath DebugPath);
@@ -178,13 +287,34 @@ protected:
 	FSVONavOctree Octree;
 	FSVONavOctree CachedOctree;
 	TArray<float> VoxelHalfSizes;
-	TArray<TSet<uint_fast64_t>> BlockedIndices;
+	// Blocked codes per layer from the coarse rasterized layer up, only alive during a build
+	TArray<FSVONavOccupancyLayer> BlockedIndices;
+	TArray<int32> NodeIdOffsets;
+	// First id of every layer 0 node plus the end of the layer, empty when the octree has no leaves
+	TArray<int32> LeafNodeIds;
+	int32 NodeIdCount = 0;
+	uint32 OctreeRevision = 0;
+	TArray<FSVONavNodeCentres> NodeCentres;
+	// Reverse search adjacency, the predecessors of node id N are Predecessors[PredecessorOffsets[N]..[N + 1])
+	TArray<int32> PredecessorOffsets;
+	TArray<FSVONavLink> Predecessors;
+	FSVONavLandmarkTable LandmarkTable;
+	// Per node id cost multiplier above 1 in CostFieldStep units, empty when no modifier touches the volume
+	TArray<uint8> CostField;
+	static constexpr float CostFieldStep = 1.f / 16.f;
+	uint32 CostRevision = 0;
+	TArray<FSVONavLink> CostChangedLinks;
+	// Leaf sub node centre relative to its layer 0 node centre, indexed by sub node morton code
+	FVector SubNodeOffsets[64];
 
 	FVector VolumeOrigin;
 	FVector VolumeExtent;
 
 	FCollisionQueryParams CollisionQueryParams;
 
+	// Geometry snapshot IsBlocked reads while a build with the geometry rasterizer runs
+	TSharedPtr<class FSVONavGeometryVoxelizer> GeometryVoxelizer;
+
 	FSVONavUpdateOctreeDelegate OnUpdateComplete;
 	bool bOctreeLocked = false;
 	bool bUpdateRequested;
@@ -238,14 +368,41 @@ protected:
 	virtual void InternalBuildOctree();
 	virtual bool FindLink(layerindex_t LayerIndex, int32 NodeIndex, uint8 Direction, FSVONavLink& Link, const FVector& NodeLocation);
 	virtual bool GetNodeIndex(layerindex_t LayerIndex, uint_fast64_t NodeMortonCode, int32& NodeIndex) const;
+	// Rebuilds everything derived from the octree for searches, after every build, update and load
+	virtual void BuildSearchData();
+	void BuildNodeIds();
+	void BuildNodeCentres();
+	void BuildPredecessors();
+	// Picks landmarks farthest apart by path and stores their distances, part of the bake rather than the search data
+	void BuildLandmarks();
+	// Dijkstra from Source over the search graph with every edge usable both ways, FLT_MAX where it cannot reach
+	void BuildLandmarkDistances(const FSVONavLink& Source, TArray<float>& OutDistances) const;
+	// Gives every node the search never stands on the range of the distances below it
+	void BuildLandmarkRanges(TArray<float>& InOutDistances, TArray<float>& OutMaxDistances) const;
+	int32 GetLandmarkNodeId(FSVONavLink Link) const;
+	// Samples the cost modifier volumes at every node centre, optionally listing the links whose cost changed
+	void BakeCostField(TArray<FSVONavLink>* OutChangedLinks = nullptr);
+	// Lets derived search data follow the cost field, ChangedLinks is null when every link may have changed
+	virtual void OnCostFieldBaked(const TArray<FSVONavLink>* ChangedLinks) {}
+
+	// Blocked codes of a layer in ascending order, found top down from the root on the worker threads
+	void RasterizeBlockedCodes(layerindex_t LayerIndex, TArray<mortoncode_t>& OutCodes) const;
+	void FilterBlockedCodes(layerindex_t LayerIndex, const TArray<mortoncode_t>& Codes, TArray<mortoncode_t>& OutCodes) const;
+	// Nodes of a sparse layer in ascending order, the children of the blocked codes one layer up
+	void GetSparseLayerCodes(layerindex_t LayerIndex, const FSVONavOccupancyLayer& BlockedParents, TArray<mortoncode_t>& OutCodes) const;
+	// Fills BlockedIndices from the blocked codes of a layer and their ancestors
+	void BuildBlockedIndices(layerindex_t LayerIndex);
+	// Blocked sub nodes of the 4x4x4 leaf centred on NodeLocation, one bit per sub node morton code
+	uint_fast64_t RasterizeLeafSubNodes(const FVector& NodeLocation, float NodeHalfSize) const;
 
 	bool IsBlocked(const FVector& Location, float Size) const;
+	// True only when the box is known to be solid throughout, false whenever that cannot be told
+	bool IsSolid(const FVector& Location, float Size) const;
 	bool IsBlocked(const FVector& Location, float Size, TArray<FOverlapResult>& OverlapResults) const;
-	bool IsAnyMemberBlocked(layerindex_t LayerIndex, mortoncode_t Code) const;
 
 	TArray<FSVONavNode>& GetLayer(const layerindex_t LayerIndex) { return Octree.Layers[LayerIndex]; };
 	const FSVONavLeafNode& GetLeafNode(nodeindex_t aIndex) const;
-	int32 GetLayerNodeCount(layerindex_t LayerIndex) const;
+	int64 GetLayerNodeCount(layerindex_t LayerIndex) const;
 	int32 GetSegmentNodeCount(layerindex_t LayerIndex) const;
 	virtual float GetActualVolumeSize() const { return FMath::Pow(2, VoxelExponent) * (VoxelSize); }
 
@@ -260,3 +417,20 @@ protected:
 	void DebugDrawNeighbourLink() const;
 	void DebugDrawBoundsMesh(FBox Box, FColor Colour) const;
 };
+
+// Remembers the centre of the last link a heuristic was evaluated against
+struct FSVONavTargetCentreCache
+{
+	FSVONavLink Link;
+	FVector Centre = FVector::ZeroVector;
+
+	FORCEINLINE const FVector& Get(const ASVONavVolumeBase& Volume, const FSVONavLink& InLink)
+	{
+		if (Link != InLink)
+		{
+			Link = InLink;
+			Centre = Volume.GetLinkCentre(InLink);
+		}
+		return Centre;
+	}
+};
@@ -1,4 +1,4 @@
-// Fill out your copyright notice in the Description page of Project Settings.
+﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 #pragma once
 
@@ -20,6 +20,24 @@ public:
 	TArray<int32> GetArrayNodeIndex(layerindex_t LayerIndex, uint_fast64_t NodeMortonCode);
 	TArray<int32> GetArrayNodeIndexExtra(layerindex_t LayerIndex, uint_fast64_t NodeMortonCode);
 	virtual void GetNeighbourLinks(const FSVONavLink& Link, TArray<FSVONavLink>& NeighbourLinks) const;
+
+	// Connected region of a link, links in different regions have no path between them
+	int32 GetComponentId(const FSVONavLink& Link) const { return ComponentIds[GetNodeId(Link)]; }
+	virtual bool IsReachable(const FSVONavLink& StartLink, const FSVONavLink& TargetLink) const override;
+
+	// Abstract graph of the region a parent node stands for, nullptr for childless nodes
+	const FSVONavRegionTable* GetRegionTable(const FSVONavLink& ParentLink) const
+	{
+		if (!LinkNodeIsValid(ParentLink)) return nullptr;
+		const int32 TableIndex = RegionTableIndices[GetNodeId(ParentLink)];
+		return TableIndex != INDEX_NONE ? &RegionTables[TableIndex] : nullptr;
+	}
+
+	// Index of a link in its parent's region table
+	int32 GetRegionMemberIndex(const FSVONavLink& Link) const { return RegionMemberIndices[GetNodeId(Link)]; }
+
+	// Links strictly between two members of the same region along its cached shortest route
+	void GetRegionRoute(const FSVONavLink& From, const FSVONavLink& To, TArray<FSVONavLink>& Route) const;
 	
 protected:
 	virtual void BeginPlay() override;
@@ -27,6 +45,8 @@ protected:
 	virtual void Initialise() override;
 	virtual void InternalBuildOctree() override;
 	virtual void Serialize(FArchive& Ar) override;
+	virtual void BuildSearchData() override;
+	virtual void OnCostFieldBaked(const TArray<FSVONavLink>* ChangedLinks) override;
 	virtual bool GetNodeIndex(layerindex_t LayerIndex, uint_fast64_t NodeMortonCode, int32& NodeIndex) const override;
 	virtual bool GetLinkLocation(const FSVONavLink& Link, FVector& Location) const override;
 	virtual void DebugDrawOctree() override;
@@ -34,6 +54,12 @@ protected:
 private:
 	TArray<int32> HierarchyStartIndex;
 	TArray<TMap<mortoncode_t, TArray<int32>>> DuplicatedMortonMatrix;
+	// Connected component label per dense node id
+	TArray<int32> ComponentIds;
+	// Region tables of every parent node, looked up by the parent's dense node id
+	TArray<FSVONavRegionTable> RegionTables;
+	TArray<int32> RegionTableIndices;
+	TArray<int32> RegionMemberIndices;
 	
 	virtual void InitRasterize();
 	void RasterizeLayer0();
@@ -42,6 +68,10 @@ private:
 	void BuildLayer0Link(layerindex_t LayerIndex);
 	void BuildLayerLink(layerindex_t LayerIndex);
 	void BuildHierarchyNodes(layerindex_t LayerIndex);
+	void BuildConnectedComponents();
+	void BuildRegionTables();
+	// Costs and next hops of a region table from its members and the current cost field
+	void BuildRegionRoutes(FSVONavRegionTable& Table) const;
 
 	bool FindLinkViaCode(layerindex_t LayerIndex, mortoncode_t MortonCode, mortoncode_t OriginalCode, uint8 Direction, FSVONavLink& Link, const FVector& NodeLocation);
 	bool FindLinkViaCodeChildlessNode(layerindex_t LayerIndex, mortoncode_t MortonCode, mortoncode_t OriginalCode, uint8 Direction, FSVONavLink& Link, const FVector& NodeLocation);
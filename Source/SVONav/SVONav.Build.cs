@@ -40,6 +40,8 @@ public class SVONav : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"Landscape",
+				"PhysicsCore",
 				"Slate",
 				"SlateCore",
 			}
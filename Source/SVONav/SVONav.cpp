@@ -1,10 +1,19 @@
 ﻿#include "SVONav.h"
 
+#include "SVONavSearchContext.h"
+#include "SVONavType.h"
+#include "Serialization/CustomVersion.h"
+
 #if WITH_EDITOR
 DEFINE_LOG_CATEGORY(LogSVONav)
 DEFINE_LOG_CATEGORY(VLogSVONav)
 #endif
 
+const FGuid FSVONavCustomVersion::GUID(0x5B2E9C41, 0x7A8D4F06, 0xB3C1E25D, 0x9F64A817);
+FCustomVersionRegistration GRegisterSVONavCustomVersion(FSVONavCustomVersion::GUID,
+                                                        FSVONavCustomVersion::LatestVersion,
+                                                        TEXT("SVONavVer"));
+
 #define LOCTEXT_NAMESPACE "FSVONavModule"
 
 void FSVONavModule::StartupModule()
@@ -14,6 +23,7 @@ void FSVONavModule::StartupModule()
 
 void FSVONavModule::ShutdownModule()
 {
+	FSVONavSearchContextPool::Get().Trim();
 	UE_LOG(LogSVONav, Warning, TEXT("SVONav: Module Shutdown"));
 }
 